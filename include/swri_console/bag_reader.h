@@ -37,38 +37,63 @@
 
 #include <rosgraph_msgs/Log.h>
 
+#include <swri_console/ingest_source.h>
+#include <swri_console/task_executor.h>
+
 namespace swri_console
 {
+  class LogDatabase;
+
   class BagReader : public QObject
   {
     Q_OBJECT
   public:
     /**
-     * Reads a bag file at the specified path.  Any log messages that were broadcast on the
-     * /rosout topic will be loaded and displayed.
-     * @param[in] filename The name of the bag file to load.
+     * @param[in] executor Bag files picked with promptForBagFile are read as BULK tasks
+     *                     on this executor.
+     * @param[in] db       Each bag file is read through its own IngestSource, which is
+     *                     added to this database for the duration of the read.
      */
-    void readBagFile(const QString& filename);
+    BagReader(TaskExecutor* executor, LogDatabase* db);
 
-  public Q_SLOTS:
     /**
-     * Displays a file dialog that prompts the user to pick a bag file.  After picking a bag
-     * file, log messages in the bag will be read and displayed in the log console.
+     * Sets the memory budget given to the source of each bag file that is read.
      */
-    void promptForBagFile();
+    void setMemoryBudget(qint64 bytes) { memory_budget_ = bytes; }
 
-  Q_SIGNALS:
+    /**
+     * Reads a bag file at the specified path on the calling thread.  Any log messages that
+     * were broadcast on the /rosout topic will be added to the source.  The read is reported
+     * with the source's lifecycle signals, using the file name as the description.
+     * @param[in] source   The source to add messages to.
+     * @param[in] filename The name of the bag file to load.
+     * @param[in] token    Reading stops early if this is cancelled.
+     */
+    void readBagFile(IngestSource* source,
+                     const QString& filename,
+                     const CancelToken& token = CancelToken());
 
     /**
-     * Emitted every time a log message is received.  This will likely be emitted several times
-     * per bag file; finishedReading will be emitted when we're done.
+     * Stops reading any bag files that are being read in the background.
      */
-    void logReceived(const rosgraph_msgs::LogConstPtr& msg);
+    void cancel();
 
+  public Q_SLOTS:
     /**
-     * Emitted after we're completely done reading the bag file.
+     * Displays a file dialog that prompts the user to pick a bag file.  After picking a bag
+     * file, log messages in the bag will be read and displayed in the log console.
      */
-    void finishedReading();
+    void promptForBagFile();
+
+  private Q_SLOTS:
+    // Removes a read's source from the database once its task is done.
+    void finishRead(QObject* source);
+
+  private:
+    TaskExecutor* executor_;
+    LogDatabase* db_;
+    qint64 memory_budget_;
+    CancelToken cancel_token_;
   };
 }
 
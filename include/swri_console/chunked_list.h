@@ -0,0 +1,260 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_CHUNKED_LIST_H_
+#define SWRI_CONSOLE_CHUNKED_LIST_H_
+
+#include <stddef.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace swri_console
+{
+/**
+ * A random-access sequence stored in blocks of up to about BLOCK_SIZE
+ * elements.  Copies share their blocks, and a block is only copied when
+ * one of the lists that share it modifies it, so copying a list costs
+ * one pointer per block and modifying a copy costs at most a few
+ * blocks.  Elements are found by binary search over the blocks, so
+ * indexing is O(log(size / BLOCK_SIZE)).
+ *
+ * Blocks that are shared may be read from other threads while the list
+ * that shares them is modified.
+ */
+template <class T>
+class ChunkedList
+{
+ public:
+  static const size_t BLOCK_SIZE = 4096;
+
+  ChunkedList() : size_(0) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const T& operator[](size_t index) const
+  {
+    size_t block = findBlock(index);
+    return (*blocks_[block])[index - starts_[block]];
+  }
+
+  /**
+   * Returns the index of the first element that isn't less than value,
+   * or size() if there is none.  The list must be sorted.
+   */
+  size_t lowerBound(const T &value) const
+  {
+    size_t low = 0;
+    size_t high = blocks_.size();
+    while (low < high) {
+      size_t mid = (low + high) / 2;
+      if (blocks_[mid]->back() < value) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    if (low == blocks_.size()) {
+      return size_;
+    }
+    const Block &block = *blocks_[low];
+    return starts_[low] + (std::lower_bound(block.begin(), block.end(), value) - block.begin());
+  }
+
+  void clear()
+  {
+    blocks_.clear();
+    starts_.clear();
+    size_ = 0;
+  }
+
+  template <class Iterator>
+  void append(Iterator first, Iterator last)
+  {
+    for (; first != last; ++first) {
+      if (blocks_.empty() || blocks_.back()->size() >= BLOCK_SIZE) {
+        starts_.push_back(size_);
+        blocks_.push_back(newBlock());
+      }
+      mutableBlock(blocks_.size() - 1).push_back(*first);
+      size_++;
+    }
+  }
+
+  template <class Iterator>
+  void prepend(Iterator first, Iterator last)
+  {
+    std::vector<T> items(first, last);
+    if (items.empty()) {
+      return;
+    }
+
+    // Top up the first block, so that prepending a few elements at a
+    // time doesn't leave a trail of tiny blocks.
+    size_t rest = items.size();
+    if (!blocks_.empty() && blocks_.front()->size() < BLOCK_SIZE) {
+      size_t count = std::min(rest, BLOCK_SIZE - blocks_.front()->size());
+      Block &front = mutableBlock(0);
+      front.insert(front.begin(), items.end() - count, items.end());
+      rest -= count;
+    }
+
+    // Only the first of the new blocks can be partly filled.
+    std::deque<BlockPtr> blocks;
+    for (size_t begin = 0; begin < rest;) {
+      size_t end = begin + (begin == 0 && rest % BLOCK_SIZE ? rest % BLOCK_SIZE : BLOCK_SIZE);
+      blocks.push_back(newBlock());
+      blocks.back()->assign(items.begin() + begin, items.begin() + end);
+      begin = end;
+    }
+    blocks_.insert(blocks_.begin(), blocks.begin(), blocks.end());
+    size_ += items.size();
+    updateStarts();
+  }
+
+  /**
+   * Inserts elements before the element at index, which may be size().
+   */
+  template <class Iterator>
+  void insert(size_t index, Iterator first, Iterator last)
+  {
+    if (index == size_) {
+      append(first, last);
+      return;
+    }
+
+    size_t block = findBlock(index);
+    Block &items = mutableBlock(block);
+    size_t old_size = items.size();
+    items.insert(items.begin() + (index - starts_[block]), first, last);
+    size_ += items.size() - old_size;
+    splitBlock(block);
+    updateStarts();
+  }
+
+  /**
+   * Erases the elements in [first, last).
+   */
+  void erase(size_t first, size_t last)
+  {
+    while (first < last) {
+      size_t block = findBlock(first);
+      Block &items = mutableBlock(block);
+      size_t offset = first - starts_[block];
+      size_t count = std::min(last - first, items.size() - offset);
+      items.erase(items.begin() + offset, items.begin() + offset + count);
+      if (items.empty()) {
+        blocks_.erase(blocks_.begin() + block);
+      }
+      size_ -= count;
+      last -= count;
+      updateStarts();
+    }
+  }
+
+  /**
+   * Appends the elements to a container.
+   */
+  template <class Container>
+  void appendTo(Container *container) const
+  {
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      container->insert(container->end(), blocks_[i]->begin(), blocks_[i]->end());
+    }
+  }
+
+ private:
+  typedef std::vector<T> Block;
+  typedef boost::shared_ptr<Block> BlockPtr;
+
+  static BlockPtr newBlock()
+  {
+    BlockPtr block(new Block());
+    block->reserve(BLOCK_SIZE);
+    return block;
+  }
+
+  size_t findBlock(size_t index) const
+  {
+    return std::upper_bound(starts_.begin(), starts_.end(), index) - starts_.begin() - 1;
+  }
+
+  // Copies the block first if another list shares it.
+  Block& mutableBlock(size_t block)
+  {
+    if (!blocks_[block].unique()) {
+      blocks_[block].reset(new Block(*blocks_[block]));
+    }
+    return *blocks_[block];
+  }
+
+  // Splits a block that has grown past twice the block size, so that a
+  // big insert doesn't leave one block that is expensive to copy.
+  void splitBlock(size_t block)
+  {
+    if (blocks_[block]->size() <= 2 * BLOCK_SIZE) {
+      return;
+    }
+
+    BlockPtr whole = blocks_[block];
+    std::vector<BlockPtr> pieces;
+    for (size_t begin = 0; begin < whole->size(); begin += BLOCK_SIZE) {
+      size_t end = std::min(whole->size(), begin + BLOCK_SIZE);
+      pieces.push_back(newBlock());
+      pieces.back()->assign(whole->begin() + begin, whole->begin() + end);
+    }
+    blocks_.erase(blocks_.begin() + block);
+    blocks_.insert(blocks_.begin() + block, pieces.begin(), pieces.end());
+  }
+
+  void updateStarts()
+  {
+    starts_.resize(blocks_.size());
+    size_t start = 0;
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      starts_[i] = start;
+      start += blocks_[i]->size();
+    }
+  }
+
+  // Every block has at least one element.  starts_[i] is the index of
+  // the first element of blocks_[i].
+  std::deque<BlockPtr> blocks_;
+  std::vector<size_t> starts_;
+  size_t size_;
+};  // class ChunkedList
+
+template <class T>
+const size_t ChunkedList<T>::BLOCK_SIZE;
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_CHUNKED_LIST_H_
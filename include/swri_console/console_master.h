@@ -38,7 +38,9 @@
 #include <rosgraph_msgs/Log.h>
 #include <swri_console/log_database.h>
 #include <swri_console/bag_reader.h>
+#include <swri_console/idle_scheduler.h>
 #include <swri_console/rosout_log_loader.h>
+#include <swri_console/task_executor.h>
 
 #include "ros_thread.h"
 
@@ -64,6 +66,10 @@ class ConsoleMaster : public QObject
   void fontChanged(const QFont &font);
 
  private:
+  // Runs background work for every window and loader.  Declared first
+  // so that the other members can be given a pointer to it.
+  TaskExecutor executor_;
+
   BagReader bag_reader_;
   RosoutLogLoader log_reader_;
 
@@ -77,6 +83,10 @@ class ConsoleMaster : public QObject
 
   LogDatabase db_;
 
+  // Shared by every window so that background work across all of them
+  // fits in a single time budget per event loop iteration.
+  IdleScheduler idle_scheduler_;
+
   QFont window_font_;
 };  // class ConsoleMaster
 }  // namespace swri_console
@@ -33,26 +33,37 @@
 
 #include <QtWidgets/QMainWindow>
 #include <QColor>
+#include <QLabel>
 #include <QPushButton>
 #include <QSettings>
+#include <QTimer>
 #include "ui_console_window.h"
 
 #include "node_click_handler.h"
 
 namespace swri_console
 {
+class IdleScheduler;
 class LogDatabase;
 class LogDatabaseProxyModel;
 class NodeListModel;
+class SearchResultsModel;
+class TaskExecutor;
 class ConsoleWindow : public QMainWindow {
   Q_OBJECT
   
  public:
-  ConsoleWindow(LogDatabase *db);
+  ConsoleWindow(LogDatabase *db, IdleScheduler *scheduler, TaskExecutor *executor);
   ~ConsoleWindow();
   
   void closeEvent(QCloseEvent *event);  // Overloaded function
 
+ protected:
+  void showEvent(QShowEvent *event);
+  void hideEvent(QHideEvent *event);
+  void changeEvent(QEvent *event);
+  bool eventFilter(QObject *obj, QEvent *event);
+
  Q_SIGNALS:
   void createNewWindow();
   void readBagFile();
@@ -65,6 +76,8 @@ class ConsoleWindow : public QMainWindow {
   void clearMessages();
   void saveLogs();
   void connected(bool);
+  void showSourceStatus(const QString &message);
+  void updateShedCounts();
   void setSeverityFilter();
   void nodeSelectionChanged();
   void messagesAdded();
@@ -74,17 +87,27 @@ class ConsoleWindow : public QMainWindow {
   void copyExtendedLogs();
   void setFollowNewest(bool);
   void toggleAlternateRowColors(bool);
+  void setShowDetails(bool);
+  void setSortNodesByRate(bool);
+  void toggleMessageExpanded(const QModelIndex &index);
+  void toggleCurrentMessageExpanded();
+  void updateDetails();
   
   void userScrolled(int);
 
   void includeFilterUpdated(const QString &);
   void excludeFilterUpdated(const QString &);
+  void applyTextFilters();
   void searchIndex();  // VM 4/13/2017
   void updateIncludeLabel();
   void updateExcludeLabel();
 
   void setFont(const QFont &font);
 
+  void messagesAboutToBeInserted(const QModelIndex &parent, int first, int last);
+  void messagesInserted(const QModelIndex &parent, int first, int last);
+  void messagesReset();
+
   void setDebugColor();
   void setInfoColor();
   void setWarnColor();
@@ -92,6 +115,8 @@ class ConsoleWindow : public QMainWindow {
   void setFatalColor();
   void prevIndex();
   void nextIndex();
+  void setFindAll(bool find_all);
+  void showSearchResult(const QModelIndex &index);
 
 private:
   enum function{NEXT,PREV,SEARCH};
@@ -110,6 +135,7 @@ private:
     }
   };
   void loadColorButtonSetting(const QString& key, QPushButton* button);
+  void updateSuspended();
   void loadSettings();
 
 
@@ -118,6 +144,18 @@ private:
   LogDatabaseProxyModel *db_proxy_;
   NodeListModel *node_list_model_;
   NodeClickHandler *node_click_handler_;
+  SearchResultsModel *search_results_;
+  // Permanent status bar label with the number of messages dropped
+  // while the ROS subscription was overloaded.
+  QLabel *shed_label_;
+
+  // Row at the top of the message list before rows are inserted above
+  // it, so that we can keep it in place.
+  int top_row_before_insert_;
+
+  // Coalesces edits to the include/exclude boxes so that we only
+  // refilter once the user pauses typing.
+  QTimer filter_timer_;
 };  // class ConsoleWindow
 }  // namespace swri_console
 
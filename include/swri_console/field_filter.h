@@ -0,0 +1,134 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_FIELD_FILTER_H_
+#define SWRI_CONSOLE_FIELD_FILTER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <QRegExp>
+#include <QStringList>
+
+#include <swri_console/string_table.h>
+
+namespace swri_console
+{
+/**
+ * Filters log entries on one of their interned string fields (node,
+ * file or function).  Filter terms have the form "field:text", which
+ * matches values containing text (case insensitive), or "field~regexp".
+ * A value is accepted if it matches any include term (or there are
+ * none) and no exclude term.
+ *
+ * Each field has its own filter and an entry has to pass all of them
+ * as well as the plain text filters.  Include terms are therefore only
+ * OR-ed with include terms for the same field: "error;file:planner"
+ * accepts entries whose text contains "error" AND whose file contains
+ * "planner".
+ *
+ * Terms are evaluated once per distinct value and the verdicts are
+ * cached by ID, so checking an entry is a single lookup no matter how
+ * expensive the terms are.
+ */
+class FieldFilter
+{
+ public:
+  /**
+   * Creates a filter for the field with the given name, which is the
+   * prefix used in filter terms.
+   */
+  explicit FieldFilter(const QString &field);
+
+  /**
+   * Returns true if the term is a filter on any supported field: a
+   * field name followed directly by ':' or '~' and the pattern, with
+   * no space in between.  Anything else is plain filter text.
+   */
+  static bool isFieldTerm(const QString &term);
+
+  /**
+   * Replaces the filter's terms with the ones for this field in the
+   * given lists; terms for other fields are ignored.
+   * @return true if the terms changed.
+   */
+  bool setTerms(const QStringList &include_terms,
+                const QStringList &exclude_terms);
+
+  /**
+   * Returns true if the filter has no terms and accepts everything.
+   */
+  bool isEmpty() const { return includes_.empty() && excludes_.empty(); }
+
+  /**
+   * Returns the filter's verdict for an interned value of the field.
+   */
+  bool accepts(const StringTable &values, uint32_t id)
+  {
+    if (values.generation() != generation_) {
+      // The table was cleared and its IDs now refer to other values.
+      verdicts_.clear();
+      generation_ = values.generation();
+    }
+    if (id >= verdicts_.size()) {
+      evaluate(values);
+    }
+    return verdicts_[id];
+  }
+
+ private:
+  struct Term
+  {
+    QString text;
+    QRegExp regexp;
+    bool use_regexp;
+
+    bool operator==(const Term &other) const
+    {
+      return use_regexp == other.use_regexp && text == other.text;
+    }
+    bool matches(const QString &value) const;
+  };
+
+  static std::vector<Term> parseTerms(const QString &field, const QStringList &terms);
+  void evaluate(const StringTable &values);
+
+  QString field_;
+  std::vector<Term> includes_;
+  std::vector<Term> excludes_;
+  // Cached verdicts indexed by value ID.  Values interned after the
+  // last evaluation are evaluated the first time they are seen.
+  std::vector<bool> verdicts_;
+  // Generation of the table that verdicts_ was built from.
+  uint32_t generation_;
+};  // class FieldFilter
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_FIELD_FILTER_H_
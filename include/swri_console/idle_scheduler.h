@@ -0,0 +1,113 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_IDLE_SCHEDULER_H_
+#define SWRI_CONSOLE_IDLE_SCHEDULER_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include <QObject>
+#include <QTimer>
+
+namespace swri_console
+{
+/**
+ * Interface for incremental work that runs on the GUI thread between
+ * events.  Implementations process a bounded number of items per call
+ * so that the IdleScheduler can keep each time slice within budget.
+ */
+class IdleTask
+{
+ public:
+  virtual ~IdleTask() {}
+
+  /**
+   * Processes up to max_items units of work.
+   * @param[in] max_items The maximum number of items to process.
+   * @return The number of items that were processed.
+   */
+  virtual size_t processIdleWork(size_t max_items) = 0;
+
+  /**
+   * Returns true if the task has more work to do.
+   */
+  virtual bool hasIdleWork() const = 0;
+};
+
+/**
+ * Runs IdleTasks cooperatively on the GUI thread.  Each time the event
+ * loop becomes idle, the scheduler runs the pending tasks for at most
+ * its time budget and then returns to the event loop so that user input
+ * is handled promptly.  Chunk sizes are derived from the measured cost
+ * per item of each task, so cheap tasks process many items per slice
+ * and expensive tasks only a few.
+ */
+class IdleScheduler : public QObject
+{
+  Q_OBJECT
+
+ public:
+  IdleScheduler();
+  ~IdleScheduler();
+
+  /**
+   * Adds a task to the schedule if it isn't already scheduled.  The task
+   * is removed automatically once hasIdleWork() returns false.
+   */
+  void schedule(IdleTask *task);
+
+  /**
+   * Removes a task from the schedule.  This must be called before a
+   * scheduled task is destroyed.
+   */
+  void cancel(IdleTask *task);
+
+ private Q_SLOTS:
+  void runSlice();
+
+ private:
+  struct TaskInfo
+  {
+    IdleTask *task;
+    // Exponentially weighted moving average of the processing time per
+    // item, in nanoseconds.
+    double ns_per_item;
+
+    TaskInfo(IdleTask *t, double cost) : task(t), ns_per_item(cost) {}
+  };
+
+  void removeCancelledTasks();
+
+  std::vector<TaskInfo> tasks_;
+  QTimer timer_;
+};  // class IdleScheduler
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_IDLE_SCHEDULER_H_
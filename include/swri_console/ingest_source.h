@@ -0,0 +1,175 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_INGEST_SOURCE_H_
+#define SWRI_CONSOLE_INGEST_SOURCE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QWaitCondition>
+
+#include <rosgraph_msgs/Log.h>
+
+#include <swri_console/task_executor.h>
+
+namespace swri_console
+{
+typedef std::vector<rosgraph_msgs::LogConstPtr> LogBatch;
+
+/**
+ * Feeds log messages into a LogDatabase from the ROS subscription, a
+ * bag file or ROS log files.  Producers call addMessage() from whatever
+ * thread they run on; messages are grouped into batches that are
+ * delivered with a single queued signal.  Sources are connected to the
+ * database with LogDatabase::addSource().  File loaders create a source
+ * for each load, so loads that run at the same time never share a
+ * batch.
+ *
+ * Sources that load a finite amount of data report their lifecycle with
+ * started(), progress(), finished() and error().  The description
+ * identifies the load (usually a file name) in status messages.
+ *
+ * The consumer reports each batch it has processed with
+ * batchConsumed().  With a memory budget set, addMessage() blocks while
+ * the batches that are still waiting to be consumed exceed the budget,
+ * so a loader runs no further ahead of the database than the budget
+ * allows.
+ *
+ * Sources that can't wait (the live ROS subscription) can set a
+ * shedding threshold instead.  While the unconsumed batches exceed it,
+ * the source is overloaded and drops low-severity messages before they
+ * are queued: every DEBUG message, and all but one in
+ * INFO_SAMPLE_INTERVAL INFO messages of each node (every INFO message
+ * past twice the threshold).  WARN and above are always kept.  The
+ * overload ends once the backlog has drained to half the threshold.
+ * Exact counts of the dropped messages are reported with
+ * messagesShed().
+ *
+ * Live sources deliver messages as they are published, so their stamps
+ * follow the current ROS time.  Messages can stop arriving at any time
+ * and a live source never finishes, so the database uses the clock
+ * rather than the newest stamp to age what it derives from them.
+ */
+class IngestSource : public QObject
+{
+  Q_OBJECT
+
+ public:
+  explicit IngestSource(QObject *parent = NULL);
+  virtual ~IngestSource();
+
+  /**
+   * Adds a message to the current batch.  Full batches are sent
+   * immediately.  Safe to call from any thread except the consumer's,
+   * since it may block until the consumer catches up.
+   */
+  void addMessage(const rosgraph_msgs::LogConstPtr &msg);
+  /**
+   * Like addMessage(msg), but stops waiting for the consumer if the
+   * token is cancelled.
+   */
+  void addMessage(const rosgraph_msgs::LogConstPtr &msg, const CancelToken &token);
+
+  /**
+   * Sends the current batch even if it isn't full.  Producers should
+   * call this whenever they pause, so messages are never held back.
+   */
+  void flush();
+
+  /**
+   * Sets the approximate number of bytes of messages that may be sent
+   * but not yet consumed before addMessage() blocks.  0 (the default)
+   * never blocks, which is what live sources need.
+   */
+  void setMemoryBudget(qint64 bytes);
+
+  /**
+   * Sets the approximate number of bytes of messages that may be sent
+   * but not yet consumed before the source starts shedding low-severity
+   * messages.  0 (the default) never sheds.
+   */
+  void setSheddingThreshold(qint64 bytes);
+
+  /**
+   * Marks the source as live (false by default).  Must be set before
+   * the source is added to a database.
+   */
+  void setLive(bool live) { live_ = live; }
+  bool isLive() const { return live_; }
+
+  /**
+   * Called by the consumer after it has processed a batch.
+   */
+  void batchConsumed(const LogBatch &batch);
+
+ Q_SIGNALS:
+  void started(const QString &description);
+  void progress(const QString &description, int percent);
+  void batchReceived(const swri_console::LogBatch &batch);
+  void finished(const QString &description);
+  void error(const QString &description, const QString &message);
+  // The numbers of DEBUG and INFO messages shed since the last time
+  // this was emitted.
+  void messagesShed(qint64 debug_count, qint64 info_count);
+
+ private:
+  static const int INFO_SAMPLE_INTERVAL = 10;
+
+  void addMessage(const rosgraph_msgs::LogConstPtr &msg, const CancelToken *token);
+  bool shouldShed(const rosgraph_msgs::Log &msg);
+  void emitBatch(const LogBatch &batch, qint64 shed_debug, qint64 shed_info);
+
+  mutable QMutex mutex_;
+  QWaitCondition consumed_;
+  LogBatch batch_;
+  qint64 memory_budget_;
+  // Approximate sizes of the current batch and of the batches that
+  // have been sent but not consumed.
+  qint64 batch_bytes_;
+  qint64 in_flight_bytes_;
+
+  qint64 shedding_threshold_;
+  bool overloaded_;
+  // Number of INFO messages from each node seen while overloaded, for
+  // sampling.
+  std::map<std::string, int> info_counts_;
+  // Messages shed since the last messagesShed() signal.
+  qint64 shed_debug_;
+  qint64 shed_info_;
+
+  bool live_;
+};  // class IngestSource
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_INGEST_SOURCE_H_
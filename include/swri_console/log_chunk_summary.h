@@ -0,0 +1,88 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOG_CHUNK_SUMMARY_H_
+#define SWRI_CONSOLE_LOG_CHUNK_SUMMARY_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include <QString>
+
+#include <ros/time.h>
+
+namespace swri_console
+{
+struct LogEntry;
+
+/**
+ * Summary of a fixed-size chunk of the log (a "zone map"): the range of
+ * timestamps, the severity levels and nodes that occur in it, and a
+ * Bloom filter of the trigrams in its messages.  Scans use it to skip
+ * whole chunks that can't contain an entry that passes their filters.
+ */
+class LogChunkSummary
+{
+ public:
+  LogChunkSummary();
+
+  void add(const LogEntry &entry);
+
+  const ros::Time& minStamp() const { return min_stamp_; }
+  const ros::Time& maxStamp() const { return max_stamp_; }
+
+  /**
+   * Returns true if an entry in the chunk has one of the levels in the
+   * mask.
+   */
+  bool hasLevel(uint8_t level_mask) const { return (level_mask_ & level_mask) != 0; }
+
+  /**
+   * Returns whether each node ID occurs in the chunk, indexed by ID.
+   * IDs past the end of the vector don't occur.
+   */
+  const std::vector<bool>& nodes() const { return nodes_; }
+
+  /**
+   * Returns false if no message in the chunk contains the text (case
+   * insensitive, with multi-line messages joined by spaces), and true
+   * if one might.  Text shorter than a trigram always returns true.
+   */
+  bool mayContain(const QString &text) const;
+
+ private:
+  ros::Time min_stamp_;
+  ros::Time max_stamp_;
+  uint8_t level_mask_;
+  std::vector<bool> nodes_;
+  std::vector<uint64_t> bloom_;
+};  // class LogChunkSummary
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOG_CHUNK_SUMMARY_H_
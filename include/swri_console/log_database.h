@@ -34,21 +34,43 @@
 #include <QObject>
 #include <QAbstractListModel>
 #include <QStringList>
+#include <QTimer>
 #include <rosgraph_msgs/Log.h>
 #include <deque>
+#include <map>
+#include <vector>
 #include <ros/time.h>
 
+#include <boost/shared_ptr.hpp>
+
+#include <swri_console/ingest_source.h>
+#include <swri_console/log_chunk_summary.h>
+#include <swri_console/log_store.h>
+#include <swri_console/node_stats.h>
+#include <swri_console/rate_limiter.h>
+#include <swri_console/string_table.h>
+#include <swri_console/text_table.h>
+
 namespace swri_console
 {
+class TaskExecutor;
+
 struct LogEntry
 {
   ros::Time stamp;
   uint8_t level;  
-  std::string node;  
-  std::string file;
-  std::string function;
+  // IDs of the interned values in LogDatabase::nodes(), files() and
+  // functions().
+  uint32_t node_id;
+  uint32_t file_id;
+  uint32_t function_id;
   uint32_t line;
+  // The lines of the message, shared with every other entry that has
+  // the same text, and the ID and version of the text in
+  // LogDatabase::texts().
   QStringList text;
+  uint32_t text_id;
+  uint32_t text_version;
   uint32_t seq;
 };
 
@@ -57,30 +79,150 @@ class LogDatabase : public QObject
   Q_OBJECT
   
 public:
-  LogDatabase();
+  /**
+   * @param[in] executor Used to compress old parts of the log in the
+   *                     background.  If NULL, the log isn't compressed.
+   */
+  explicit LogDatabase(TaskExecutor *executor = NULL);
   ~LogDatabase();
   
   void clear();
-  const std::deque<LogEntry>& log() { return log_; }
+
+  // The executor given to the constructor, which may be NULL.
+  TaskExecutor* executor() const { return executor_; }
+
+  /**
+   * Connects a source so that its batches are added to the database and
+   * its lifecycle is reported through sourceStatus().
+   */
+  void addSource(IngestSource *source);
+  /**
+   * Disconnects a source added with addSource() and reports the
+   * summaries of whatever its rate limits suppressed.  Call it once
+   * the source's last batch has been delivered.
+   */
+  void removeSource(IngestSource *source);
+
+  // Numbers of DEBUG and INFO messages that overloaded sources have
+  // dropped since the database was last cleared.
+  qint64 shedDebugCount() const { return shed_debug_count_; }
+  qint64 shedInfoCount() const { return shed_info_count_; }
+
+  // Limits how many messages per second each node, and each file:line,
+  // may add to the log.  Suppressed messages are replaced by summary
+  // entries.  A rate of 0 disables the limit.  Each source is limited
+  // separately, since sources have unrelated timelines.  File loaders
+  // use a new source for every load, so two files loading at once
+  // don't restart each other's buckets or flush each other's
+  // summaries.
+  void setNodeRateLimit(double rate, double burst);
+  void setLocationRateLimit(double rate, double burst);
+
+  // The log may only be read directly from the GUI thread.  Other
+  // threads should work from log().snapshot().
+  const LogStore& log() const { return log_; }
   const ros::Time& minTime() const { return min_time_; }
+  // The newest stamp in the log.
+  const ros::Time& maxTime() const { return max_time_; }
 
-  const std::map<std::string, size_t>& messageCounts() const { return msg_counts_; }
+  // Running statistics of each node's messages, indexed by node ID.
+  // IDs past the end of the vector have no messages.
+  const std::vector<NodeStats>& nodeStats() const { return node_stats_; }
+  // Returns a node's current message rate.  Nodes heard from a live
+  // source decay against the current ROS time, so their rates fall off
+  // when they go quiet.  Other nodes decay against maxTime(), so a bag
+  // file shows the rates it recorded.
+  double nodeRate(uint32_t node_id) const;
+  // IDs of the nodes whose statistics changed with the last
+  // messagesAdded().
+  const std::vector<uint32_t>& changedNodes() const { return changed_nodes_; }
+
+  // Interned field values and message texts.  These are reset when the
+  // database is cleared, so anything cached by ID must be dropped when
+  // the table's generation() changes.
+  const StringTable& nodes() const { return nodes_; }
+  const StringTable& files() const { return files_; }
+  const StringTable& functions() const { return functions_; }
+  const TextTable& texts() const { return texts_; }
+
+  // Column statistics used to plan queries: the number of entries in
+  // log() with a severity level, and with each node, file and function
+  // ID (indexed by ID).
+  size_t levelCount(uint8_t level) const;
+  const std::vector<size_t>& nodeCounts() const { return node_counts_; }
+  const std::vector<size_t>& fileCounts() const { return file_counts_; }
+  const std::vector<size_t>& functionCounts() const { return function_counts_; }
+
+  // The log is divided into chunks of CHUNK_SIZE consecutive entries,
+  // each with a summary that lets scans skip chunks without a match.
+  static const size_t CHUNK_SIZE = LogStore::CHUNK_SIZE;
+  // Returns the summary of the chunk that contains a log index.
+  const LogChunkSummary& chunkSummary(size_t log_index) const
+  {
+    return (*chunk_summaries_)[log_index / CHUNK_SIZE];
+  }
 
  Q_SIGNALS:
   void databaseCleared();
   void messagesAdded();
   void minTimeUpdated();
+  // A human-readable update on a source's progress, for a status bar.
+  void sourceStatus(const QString &message);
+  void shedCountsChanged();
 
 public Q_SLOTS:
-  void queueMessage(const rosgraph_msgs::LogConstPtr msg);
   void processQueue();
 
+private Q_SLOTS:
+  void queueBatch(const swri_console::LogBatch &batch);
+  void handleSourceStarted(const QString &description);
+  void handleSourceProgress(const QString &description, int percent);
+  void handleSourceFinished(const QString &description);
+  void handleSourceError(const QString &description, const QString &message);
+  void handleMessagesShed(qint64 debug_count, qint64 info_count);
+  void handleSourceDestroyed(QObject *source);
+  void flushLiveSummaries();
+
 private:  
-  std::map<std::string, size_t> msg_counts_;
-  std::deque<LogEntry> log_;
+  void addMessage(const rosgraph_msgs::LogConstPtr &msg, RateLimiter &limiter, bool live);
+  RateLimiter& rateLimiter(IngestSource *source);
+  void queueSuppressionSummaries(RateLimiter &limiter, bool force);
+  NodeStats& touchNodeStats(uint32_t node_id);
+
+  TaskExecutor *executor_;
+  LogStore log_;
   std::deque<LogEntry> new_msgs_;
+  StringTable nodes_;
+  StringTable files_;
+  StringTable functions_;
+  TextTable texts_;
+
+  std::map<uint8_t, size_t> level_counts_;
+  std::vector<size_t> node_counts_;
+  std::vector<size_t> file_counts_;
+  std::vector<size_t> function_counts_;
+  // Held by pointer so that clear() can hand the old summaries to the
+  // executor instead of freeing them on the GUI thread.
+  boost::shared_ptr<std::deque<LogChunkSummary> > chunk_summaries_;
+
+  qint64 shed_debug_count_;
+  qint64 shed_info_count_;
+  double node_rate_limit_;
+  double node_burst_;
+  double location_rate_limit_;
+  double location_burst_;
+  // One limiter per source.
+  std::map<IngestSource*, RateLimiter> rate_limiters_;
+  // Flushes the summaries of live sources when their messages stop.
+  QTimer summary_timer_;
+
+  std::vector<NodeStats> node_stats_;
+  // Nodes with statistics that haven't been folded into their rates.
+  std::vector<uint32_t> pending_nodes_;
+  std::vector<uint32_t> changed_nodes_;
 
   ros::Time min_time_;
+  ros::Time max_time_;
 };  // class LogDatabase
 }  // namespace swri_console 
 #endif  // SWRI_CONSOLE_LOG_DATABASE_H_
@@ -33,6 +33,8 @@
 
 #include <QAbstractListModel>
 #include <QColor>
+#include <QItemSelection>
+#include <QMimeData>
 #include <QStringList>
 #include <QRegExp>
 
@@ -40,22 +42,50 @@
 #include <set>
 #include <string>
 #include <deque>
+#include <vector>
+
+
+#include <swri_console/field_filter.h>
+#include <swri_console/idle_scheduler.h>
+#include <swri_console/log_line_format.h>
+#include <swri_console/log_query.h>
+#include <swri_console/regexp_prefilter.h>
 
 namespace swri_console
 {
 
 class LogDatabase;
 struct LogEntry;
-class LogDatabaseProxyModel : public QAbstractListModel
+class LogDatabaseProxyModel : public QAbstractListModel, public IdleTask
 {
   Q_OBJECT
  
  public:
   enum {
-    ExtendedLogRole = Qt::UserRole + 0
+    ExtendedLogRole = Qt::UserRole + 0,
+    // Same as Qt::DisplayRole, but without eliding long lines.
+    FullTextRole = Qt::UserRole + 1
+  };
+
+  // For performance reasons, the proxy model presents single line
+  // items, while the underlying log database stores multi-line
+  // messages.  The LineMap struct is used to map our item indices to
+  // the log & line that it represents.
+  struct LineMap {
+    size_t log_index;
+    int line_index;
+
+    LineMap() : log_index(0), line_index(0) {}
+    LineMap(size_t log, int line) : log_index(log), line_index(line) {}
+
+    bool operator<(const LineMap &other) const
+    {
+      return (log_index < other.log_index ||
+              (log_index == other.log_index && line_index < other.line_index));
+    }
   };
 
-  LogDatabaseProxyModel(LogDatabase *db);
+  LogDatabaseProxyModel(LogDatabase *db, IdleScheduler *scheduler);
   ~LogDatabaseProxyModel();
 
   void setNodeFilter(const std::set<std::string> &names);
@@ -64,21 +94,70 @@ class LogDatabaseProxyModel : public QAbstractListModel
   void setExcludeFilters(const QStringList &list);
   void setIncludeRegexpPattern(const QString& pattern);
   void setExcludeRegexpPattern(const QString& pattern);
+  // Sets the node, file and function filters from terms such as
+  // "file~planner/" or "function:computePath" (see FieldFilter).
+  void setFieldFilters(const QStringList &include_terms,
+                       const QStringList &exclude_terms);
+  // Sets the query that replaces the include filters when the query
+  // language is enabled (see LogQuery).
+  void setQuery(const QString &text);
+  // Filter updates made between these calls are combined and applied
+  // with a single refill when the outermost endFilterUpdate() is
+  // called.
+  void beginFilterUpdate();
+  void endFilterUpdate();
   void setDebugColor(const QColor& debug_color);
   void setInfoColor(const QColor& info_color);
   void setWarnColor(const QColor& warn_color);
   void setErrorColor(const QColor& error_color);
   void setFatalColor(const QColor& fatal_color);
   bool isIncludeValid() const;
+  const QString& queryError() const { return query_.errorString(); }
   bool isExcludeValid() const;
   int getItemIndex(const QString searchText, int index, int increment);
   void clearSearchFailure();
 
   virtual int rowCount(const QModelIndex &parent) const;
   virtual QVariant data(const QModelIndex &index, int role) const;
+  // Returns the data for a line of a log entry, independent of its
+  // current row.
+  QVariant lineData(const LineMap &line, int role) const;
+
+  // Creates clipboard data for the selected rows.  The selection, the
+  // log and the display options are captured as they are now, and the
+  // text is formatted in the background.
+  QMimeData* createClipboardData(const QItemSelection &selection,
+                                 int role,
+                                 const QString &separator);
+
+  virtual size_t processIdleWork(size_t max_items);
+  virtual bool hasIdleWork() const;
 
   void reset();
 
+  // Records the row at the top of the viewport, or -1 if the view is
+  // following the newest messages.  Refiltering starts at this entry
+  // and works outward so that the visible rows are filled in first.
+  void setViewportAnchor(int row);
+  // Returns the current row of the viewport anchor entry, or -1 if
+  // there is no anchor.
+  int anchorRow() const;
+
+  // Returns the log index of the entry shown at a row.
+  size_t logIndex(int row) const { return msg_mapping_[row].log_index; }
+  // Returns the first row of a log entry, or -1 if the entry isn't in
+  // the view.
+  int rowForLogIndex(size_t log_index) const;
+
+  // Suspends processing while the view isn't visible.  New messages
+  // are left in the database and processed in a single pass when the
+  // model is resumed.
+  void setSuspended(bool suspended);
+
+  // Multi-line messages are shown collapsed to their first line.  This
+  // expands or collapses the message shown at the given row in place.
+  void toggleExpanded(int row);
+
   void saveToFile(const QString& filename) const;
 
  Q_SIGNALS:
@@ -87,7 +166,6 @@ class LogDatabaseProxyModel : public QAbstractListModel
  public Q_SLOTS:
   void handleDatabaseCleared();
   void processNewMessages();
-  void processOldMessages();
   void minTimeUpdated();
   void setDisplayTime(bool display);
   void setAbsoluteTime(bool absolute);
@@ -95,16 +173,82 @@ class LogDatabaseProxyModel : public QAbstractListModel
   void setDisplayFunction(bool function_name);
   void setColorizeLogs(bool colorize_logs);
   void setUseRegularExpressions(bool useRegexps);
+  void setUseQueryLanguage(bool use_query);
 
  private:
+  // Describes how a filter update relates to the previous filter
+  // state.  A narrowed filter only accepts a subset of what the
+  // previous filter accepted, and a widened filter accepts a
+  // superset.  This lets us avoid rescanning the entire database for
+  // the most common updates (e.g. typing into the include box).
+  enum FilterChange {
+    FILTER_UNCHANGED,
+    FILTER_NARROWED,
+    FILTER_WIDENED,
+    FILTER_CHANGED
+  };
+
   void saveBagFile(const QString& filename) const;
   void saveTextFile(const QString& filename) const;
   void scheduleIdleProcessing();
+
+  void appendMessages(size_t end_index);
+
+  void applyFilterChange(FilterChange change);
+  // Clears the mapping and starts refilling it from the viewport
+  // anchor.  If previous_rows is given, it receives the old mapping.
+  void restartFill(std::deque<LineMap> *previous_rows = NULL);
+  // Returns the current display options for formatting lines.
+  LogLineFormat lineFormat() const;
+  void releaseHint();
+  
+  // Returns the number of rows that the entry at log_index gets under
+  // the current filters, or 0 if it is rejected.
+  int filteredLineCount(size_t log_index);
+  // Returns the log index of the first hint entry at or after
+  // log_index, or hint_end_ if there isn't one.
+  size_t nextHintIndex(size_t log_index) const;
+  // Finds the log index of the last hint entry at or before log_index.
+  // Returns false if there isn't one.
+  bool previousHintIndex(size_t log_index, size_t *previous) const;
+  bool hintCovers(size_t log_index) const
+  {
+    return hint_change_ != FILTER_UNCHANGED &&
+      log_index >= hint_begin_ && log_index < hint_end_;
+  }
   
   bool acceptLogEntry(const LogEntry &item);
-  bool testIncludeFilter(const LogEntry &item);
+  bool acceptNode(uint32_t node_id);
+  // Returns false if no entry in the chunk containing log_index can
+  // pass the filters, based on the chunk's summary.
+  bool chunkMayMatch(size_t log_index);
+  bool acceptText(const LogEntry &item);
+  bool testIncludeFilter(const QString &text);
+  bool testExcludeFilter(const QString &text);
   
   std::set<std::string> names_;
+  // Whether each interned node name is in names_, indexed by node ID.
+  // Extended as new nodes show up and cleared when names_ changes.
+  std::vector<bool> accepted_nodes_;
+  // Generations of the node and text tables that accepted_nodes_ and
+  // text_verdicts_ were built from.
+  uint32_t node_generation_;
+  uint32_t text_generation_;
+  // Verdicts of the include and exclude filters for each distinct
+  // message text, indexed by text ID, with the version of the ID that
+  // each was found for.  Cleared when those filters change.
+  enum TextVerdict { TEXT_UNKNOWN, TEXT_ACCEPTED, TEXT_REJECTED };
+  struct CachedTextVerdict
+  {
+    uint32_t version;
+    uint8_t verdict;
+
+    CachedTextVerdict() : version(0), verdict(TEXT_UNKNOWN) {}
+  };
+  std::vector<CachedTextVerdict> text_verdicts_;
+  FieldFilter node_field_filter_;
+  FieldFilter file_field_filter_;
+  FieldFilter function_field_filter_;
   uint8_t severity_mask_;
   bool colorize_logs_;
   bool display_time_;
@@ -112,29 +256,52 @@ class LogDatabaseProxyModel : public QAbstractListModel
   bool display_logger_;
   bool display_function_;
   bool use_regular_expressions_;
+  bool use_query_language_;
+  bool suspended_;
 
-  // For performance reasons, the proxy model presents single line
-  // items, while the underlying log database stores multi-line
-  // messages.  The LineMap struct is used to map our item indices to
-  // the log & line that it represents.
-  struct LineMap {
-    size_t log_index;
-    int line_index;
-
-    LineMap() : log_index(0), line_index(0) {}
-    LineMap(size_t log, int line) : log_index(log), line_index(line) {}
-  };
-  
+  int visibleLineCount(size_t log_index, const LogEntry &item) const;
+  // msg_mapping_ covers the log entries from earliest_log_index_ up
+  // to latest_log_index_.  After a reset, both indices start at the
+  // viewport anchor; the idle processing fills in the older entries
+  // backwards and the newer entries forwards until filling_forward_
+  // is cleared, at which point processNewMessages() takes over.  The
+  // mapping's blocks are shared with clipboard data, which only copies
+  // the blocks that are modified while it holds them.
   size_t latest_log_index_;
-  std::deque<LineMap> msg_mapping_;
+  ChunkedList<LineMap> msg_mapping_;
+  bool filling_forward_;
+
+  // After a narrowing or widening filter change, the mapping is
+  // refilled like after a reset, but the rows that the previous filters
+  // accepted over [hint_begin_, hint_end_) are kept as a hint.  When
+  // narrowed, only the entries in the hint need to be tested; when
+  // widened, the entries in the hint are accepted without testing.
+  // The hint is dropped once the refill is complete.
+  FilterChange hint_change_;
+  int filter_update_depth_;
+  FilterChange pending_change_;
+  std::deque<LineMap> hint_mapping_;
+  size_t hint_begin_;
+  size_t hint_end_;
+
+  // Log indices of the multi-line entries that the user has expanded.
+  // All other entries are represented by a single row.
+  std::set<size_t> expanded_entries_;
+
+  // Log index of the entry at the top of the viewport, or NO_ANCHOR.
+  size_t anchor_log_index_;
+  static const size_t NO_ANCHOR;
 
   size_t earliest_log_index_;
-  std::deque<LineMap> early_mapping_;
 
   QRegExp include_regexp_;
   QRegExp exclude_regexp_;
+  // Reject most non-matching messages before the regexps are run.
+  RegExpPrefilter include_prefilter_;
+  RegExpPrefilter exclude_prefilter_;
   QStringList include_strings_;
   QStringList exclude_strings_;
+  LogQuery query_;
 
   QColor debug_color_;
   QColor info_color_;
@@ -142,6 +309,10 @@ class LogDatabaseProxyModel : public QAbstractListModel
   QColor error_color_;
   QColor fatal_color_;
   LogDatabase *db_;
+  // Runs the incremental refiltering.  The model is scheduled at most
+  // once, so restarting the scan after a filter change replaces the
+  // stale scan instead of running alongside it.
+  IdleScheduler *scheduler_;
 
   QString failedSearchText_;  // stores last failed search text, used to minimize looping through full data set, VCM 26 April 2017
   int failedSearchIndex_;  // stores last index of failed search text, VCM 26 April 2017
@@ -0,0 +1,84 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOG_LINE_FORMAT_H_
+#define SWRI_CONSOLE_LOG_LINE_FORMAT_H_
+
+#include <QString>
+
+#include <ros/time.h>
+
+namespace swri_console
+{
+class StringTable;
+struct LogEntry;
+
+/**
+ * The display options that determine how a log line is formatted.
+ * These are plain values so that a copy can be taken along with a
+ * snapshot of the log and used on another thread.
+ */
+struct LogLineFormat
+{
+  LogLineFormat();
+
+  bool display_time;
+  bool display_absolute_time;
+  bool display_logger;
+  bool display_function;
+  // Relative timestamps are measured from this time.
+  ros::Time min_time;
+};
+
+/**
+ * Formats one line of an entry with its severity, time and logger
+ * header.  A collapsed multi-line entry is either the first line with a
+ * badge counting the hidden lines or, if full_text is set, every line
+ * with the continuation lines indented under the header.  Unless
+ * full_text is set, very long lines are elided.
+ */
+QString formatLogLine(const LogEntry &entry,
+                      int line_index,
+                      bool collapsed,
+                      bool full_text,
+                      const LogLineFormat &format,
+                      const StringTable &nodes,
+                      const StringTable &functions);
+
+/**
+ * Formats an entry with all of its fields on separate lines, followed
+ * by the full message.
+ */
+QString formatExtendedLog(const LogEntry &entry,
+                          const StringTable &nodes,
+                          const StringTable &functions,
+                          const StringTable &files);
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOG_LINE_FORMAT_H_
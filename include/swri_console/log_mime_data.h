@@ -0,0 +1,109 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOG_MIME_DATA_H_
+#define SWRI_CONSOLE_LOG_MIME_DATA_H_
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <QMimeData>
+#include <QString>
+#include <QStringList>
+
+#include <boost/shared_ptr.hpp>
+
+#include <swri_console/chunked_list.h>
+#include <swri_console/log_database_proxy_model.h>
+#include <swri_console/log_line_format.h>
+#include <swri_console/task_executor.h>
+
+namespace swri_console
+{
+class LogDatabase;
+
+/**
+ * Clipboard data for a selection of log lines.  Copying millions of
+ * lines would take a long time and a lot of memory if we formatted them
+ * when they are copied, so this only captures a snapshot of the log, the
+ * model's row mapping (sharing its blocks) with the selected row ranges,
+ * and the display options.  The text is formatted the first time it is
+ * pasted, split between the calling thread and the executor's workers,
+ * and the captured state is released once it has been formatted.
+ * The captured state doesn't depend on the database or the model, so
+ * later changes to either don't affect what is pasted.  When the
+ * database is cleared, a small copy that hasn't been pasted is
+ * formatted right away, and a large one is dropped so that it doesn't
+ * keep the cleared log alive; after that the data has no formats.
+ */
+class LogMimeData : public QMimeData
+{
+  Q_OBJECT
+
+ public:
+  /**
+   * @param[in] db               The database that the lines refer to.
+   * @param[in] format           The display options at the time of the copy.
+   * @param[in] expanded_entries The multi-line entries that are expanded.
+   * @param[in] rows             The model's row mapping.
+   * @param[in] ranges           The selected rows, as sorted and disjoint
+   *                             inclusive ranges of rows.
+   * @param[in] role             The model role used to format each line.
+   * @param[in] separator        The text placed between lines.
+   */
+  LogMimeData(const LogDatabase *db,
+              const LogLineFormat &format,
+              const std::set<size_t> &expanded_entries,
+              const ChunkedList<LogDatabaseProxyModel::LineMap> &rows,
+              const std::vector<std::pair<int, int> > &ranges,
+              int role,
+              const QString &separator);
+  ~LogMimeData();
+
+  virtual QStringList formats() const;
+
+  // The captured state and the formatted text, shared with the worker
+  // threads.
+  struct Job;
+
+ protected:
+  virtual QVariant retrieveData(const QString &mimetype, QVariant::Type type) const;
+
+ private Q_SLOTS:
+  void handleDatabaseCleared();
+
+ private:
+  boost::shared_ptr<Job> job_;
+  TaskExecutor *executor_;
+  CancelToken cancel_token_;
+};  // class LogMimeData
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOG_MIME_DATA_H_
@@ -0,0 +1,107 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOG_QUERY_H_
+#define SWRI_CONSOLE_LOG_QUERY_H_
+
+#include <stddef.h>
+
+#include <QString>
+
+#include <boost/shared_ptr.hpp>
+
+namespace swri_console
+{
+class LogChunkSummary;
+class LogDatabase;
+struct LogEntry;
+class QueryNode;
+
+/**
+ * A filter written in a small query language, for example:
+ *
+ *   level>=WARN and node:planner and not msg~"retry"
+ *
+ * Predicates are "level OP NAME" (OP is one of = != < <= > >=),
+ * "time OP SECONDS" (OP is one of < <= > >=, and SECONDS counts from
+ * the first message in the log, like the time column) and
+ * "FIELD:PATTERN" or "FIELD~REGEXP", where FIELD is node, file,
+ * function or msg.  ":" matches a case-insensitive substring, or the
+ * whole value if the pattern contains * or ? wildcards.  A bare word or
+ * quoted string is a message substring.  Predicates are combined with
+ * and, or, not and parentheses; "and" binds tighter than "or".
+ *
+ * The parsed query is compiled into a plan that evaluates the cheapest
+ * and most selective predicates first, based on the column statistics
+ * of the database.
+ */
+class LogQuery
+{
+ public:
+  explicit LogQuery(const LogDatabase *db);
+  ~LogQuery();
+
+  /**
+   * Parses and plans a query.  An empty query accepts everything.
+   * @return false if the query is invalid, in which case it also
+   *         accepts everything and errorString() describes the problem.
+   */
+  bool parse(const QString &text);
+
+  const QString& text() const { return text_; }
+  bool isValid() const { return error_.isEmpty(); }
+  const QString& errorString() const { return error_; }
+
+  /**
+   * Replans the query if the database has changed enough since the
+   * last plan for the statistics to be stale.
+   */
+  void refreshPlan();
+
+  bool accepts(const LogEntry &entry);
+
+  /**
+   * Returns false if the query can't accept any entry of a chunk with
+   * this summary, so scans can skip the chunk.
+   */
+  bool mayMatch(const LogChunkSummary &summary);
+
+ private:
+  void plan();
+
+  const LogDatabase *db_;
+  QString text_;
+  QString error_;
+  boost::shared_ptr<QueryNode> root_;
+  // Size of the database when the query was last planned.
+  size_t planned_size_;
+};  // class LogQuery
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOG_QUERY_H_
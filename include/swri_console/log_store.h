@@ -0,0 +1,164 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOG_STORE_H_
+#define SWRI_CONSOLE_LOG_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace swri_console
+{
+struct LogEntry;
+struct LogStoreChunk;
+struct LogStoreState;
+struct CompressedChunks;
+class TaskExecutor;
+
+/**
+ * The most recently decoded compressed chunks of a LogStore.  Each
+ * reader keeps its own cache, so it needs no locking.
+ */
+class DecodedChunkCache
+{
+ public:
+  /**
+   * Returns the entries of a compressed chunk, decoding it if it isn't
+   * in the cache.  The reference stays valid until CACHE_SIZE other
+   * chunks have been decoded.
+   */
+  const std::vector<LogEntry>& entries(const boost::shared_ptr<const LogStoreChunk> &chunk);
+
+ private:
+  static const size_t CACHE_SIZE = 8;
+
+  // Most recently used first.
+  std::deque<std::pair<boost::shared_ptr<const LogStoreChunk>,
+                       boost::shared_ptr<const std::vector<LogEntry> > > > chunks_;
+};  // class DecodedChunkCache
+
+/**
+ * An immutable view of a LogStore at some point in time.  Snapshots can
+ * be copied to and read from any thread, and they keep the entries
+ * they cover alive even if the store is cleared in the meantime.  A
+ * single snapshot object must not be read from several threads at
+ * once; give each thread its own copy.
+ */
+class LogSnapshot
+{
+ public:
+  LogSnapshot();
+
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+  const LogEntry& operator[](size_t index) const;
+
+ private:
+  friend class LogStore;
+  explicit LogSnapshot(const boost::shared_ptr<const LogStoreState> &state);
+
+  boost::shared_ptr<const LogStoreState> state_;
+  mutable DecodedChunkCache cache_;
+};  // class LogSnapshot
+
+/**
+ * Append-only log storage that supports concurrent readers.
+ *
+ * Entries are stored in fixed-size chunks that never move once they are
+ * allocated.  The list of chunks and the number of entries are
+ * published together as an immutable state; appending fills the free
+ * slots of the last chunk (which no published state covers yet) and
+ * then publishes a new state.  Readers on other threads take a
+ * snapshot() of the published state and see a consistent log without
+ * any further locking.  Memory is reclaimed by reference counting: the
+ * chunks of a cleared log are freed when the last snapshot that covers
+ * them is released.
+ *
+ * Full chunks that are far enough from the end of the log are
+ * compressed in the background by compressColdChunks() and swapped in
+ * for the originals.  Reading an entry of a compressed chunk decodes
+ * the whole chunk into the reader's DecodedChunkCache, so references
+ * returned by operator[] should not be held across reads of other
+ * entries.
+ *
+ * Only the thread that owns the store (the GUI thread) may append,
+ * clear, compress, or use operator[] and size() directly.
+ */
+class LogStore
+{
+ public:
+  static const size_t CHUNK_SIZE = 1024;
+
+  LogStore();
+
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+  const LogEntry& operator[](size_t index) const;
+
+  void append(const std::deque<LogEntry> &entries);
+
+  /**
+   * Replaces the contents with an empty log in constant time.  The old
+   * chunks are handed to the executor to be freed in the background (or
+   * freed here if executor is NULL), unless snapshots still use them.
+   */
+  void clear(TaskExecutor *executor);
+
+  /**
+   * Installs the chunks that have finished compressing and queues the
+   * chunks that have gone cold since the last call as RECLAIM tasks on
+   * the executor.  The text ID of every entry in the installed chunks
+   * is appended to released_texts, since the compressed chunks carry
+   * their own copies of the texts.
+   */
+  void compressColdChunks(TaskExecutor *executor,
+                          std::vector<uint32_t> *released_texts);
+
+  /**
+   * Returns a snapshot of the store.  Safe to call from any thread.
+   */
+  LogSnapshot snapshot() const;
+
+ private:
+  boost::shared_ptr<const LogStoreState> state_;
+  mutable DecodedChunkCache cache_;
+
+  // Chunks finished by the compression tasks, waiting to be installed.
+  boost::shared_ptr<CompressedChunks> compressed_;
+  // Index of the first chunk that hasn't been queued for compression.
+  size_t next_cold_chunk_;
+};  // class LogStore
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOG_STORE_H_
@@ -0,0 +1,84 @@
+// *****************************************************************************
+//
+// Copyright (c) 2016, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOGGER_LEVEL_DIALOG_H_
+#define SWRI_CONSOLE_LOGGER_LEVEL_DIALOG_H_
+
+#include <map>
+
+#include <QDialog>
+#include <QLabel>
+#include <QListWidget>
+#include <QStringList>
+
+namespace swri_console
+{
+class LoggerService;
+
+/**
+ * Non-modal dialog that changes the logger levels of several nodes at
+ * once and shows the outcome for each node as the calls finish.
+ */
+class LoggerLevelDialog : public QDialog
+{
+  Q_OBJECT
+
+ public:
+  /**
+   * Creates the dialog and starts setting the loggers of the given
+   * nodes that match the wildcard pattern to the given level.
+   */
+  LoggerLevelDialog(LoggerService *service,
+                    const QStringList &nodes,
+                    const QString &pattern,
+                    const QString &level,
+                    QWidget *parent = NULL);
+
+ private Q_SLOTS:
+  void handleMatchingLevelSet(int request_id,
+                              const QString &node,
+                              const QString &level,
+                              int logger_count,
+                              bool success,
+                              const QString &error);
+
+ private:
+  void updateSummary();
+
+  // Identifies this dialog's calls among the results of every call.
+  int request_id_;
+  QLabel *summary_;
+  QListWidget *results_;
+  std::map<QString, QListWidgetItem*> pending_;
+  int succeeded_;
+  int failed_;
+};  // class LoggerLevelDialog
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOGGER_LEVEL_DIALOG_H_
@@ -0,0 +1,212 @@
+// *****************************************************************************
+//
+// Copyright (c) 2016, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_LOGGER_SERVICE_H_
+#define SWRI_CONSOLE_LOGGER_SERVICE_H_
+
+#include <map>
+#include <set>
+
+#include <boost/thread.hpp>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <ros/ros.h>
+#include <ros/service_client.h>
+
+#include <swri_console/task_executor.h>
+
+namespace swri_console
+{
+/**
+ * Queries and changes the logger levels of ROS nodes without blocking
+ * the GUI thread.  Service calls are made on a worker thread pool and
+ * the results are delivered through signals on the GUI thread.  Logger
+ * lists are cached per node for a short time so that menus for
+ * recently used or prefetched nodes can be shown immediately.
+ *
+ * Prefetches are speculative, so they run one at a time on their own
+ * thread and never delay the calls the user is waiting on.
+ */
+class LoggerService : public QObject
+{
+  Q_OBJECT
+
+ public:
+  explicit LoggerService(QObject *parent = NULL);
+  ~LoggerService();
+
+  /**
+   * Retrieves the cached logger list for a node.
+   * @return true if an unexpired list was available.
+   */
+  bool cachedLoggers(const QString &node,
+                     QStringList *names,
+                     QStringList *levels) const;
+
+  /**
+   * Starts fetching the logger list for a node in the background.  Does
+   * nothing if the cached list is still fresh or a fetch for the node is
+   * already in progress.  Either loggersReceived() or loggersFailed() is
+   * emitted when the fetch finishes.
+   */
+  void fetchLoggers(const QString &node);
+
+  /**
+   * Starts fetching the logger list for a node in case it is needed
+   * soon.  Replaces the previous prefetch: if that hasn't reached its
+   * service call yet, it is dropped.  Failures aren't reported.
+   */
+  void prefetchLoggers(const QString &node);
+
+  /**
+   * Drops the current prefetch, if it hasn't reached its service call.
+   */
+  void cancelPrefetch();
+
+  /**
+   * Sets the level of the given loggers of a node in the background.
+   * loggerLevelSet() is emitted when all of the calls have finished.
+   */
+  void setLoggerLevel(const QString &node,
+                      const QStringList &loggers,
+                      const QString &level);
+
+  /**
+   * Returns a new ID for setMatchingLoggerLevel() requests.  IDs are
+   * never reused, so a caller can tell its results from those of other
+   * callers that change the same nodes.
+   */
+  int createRequestId() { return ++last_request_id_; }
+
+  /**
+   * Sets the level of every logger of a node whose name matches a
+   * wildcard pattern, such as "ros.*", in the background.
+   * matchingLevelSet() is emitted with the request ID when the calls
+   * have finished.  Calls for different nodes run concurrently, up to a
+   * bounded number at a time.
+   */
+  void setMatchingLoggerLevel(int request_id,
+                              const QString &node,
+                              const QString &pattern,
+                              const QString &level);
+
+  /**
+   * Attempts to call a ROS service.  Will time out and return false if the service call
+   * does not return within a specified time.
+   *
+   * ROS service clients do not have any built-in timeout mechanism, so we have to wrap our own
+   * around the service call.  If we don't, a call to a hanged node could tie up a worker
+   * thread forever.
+   * @tparam T Type of the ROS service
+   * @param client An initialized ros::ServiceClient
+   * @param service An instance of the ROS service
+   * @param timeout_secs The number of seconds to wait before timing out
+   * @return true if the service call completed successfully, otherwise false
+   */
+  template <class T>
+  static bool callService(ros::ServiceClient& client, T& service, int timeout_secs = 5)
+  {
+    bool success = false;
+    boost::thread svc_thread(&LoggerService::callServiceWorker<T>, client, &service, &success);
+
+    if (svc_thread.try_join_for(boost::chrono::seconds(timeout_secs))) {
+      return success;
+    }
+    svc_thread.interrupt();
+    return false;
+  }
+
+ Q_SIGNALS:
+  void loggersReceived(const QString &node,
+                       const QStringList &names,
+                       const QStringList &levels);
+  void loggersFailed(const QString &node, const QString &error);
+  void loggerLevelSet(const QString &node,
+                      const QString &level,
+                      bool success,
+                      const QString &error);
+  void matchingLevelSet(int request_id,
+                        const QString &node,
+                        const QString &level,
+                        int logger_count,
+                        bool success,
+                        const QString &error);
+
+ private Q_SLOTS:
+  // Invoked from the worker threads through queued connections.
+  void handleLoggers(const QString &node,
+                     const QStringList &names,
+                     const QStringList &levels,
+                     bool success,
+                     const QString &error,
+                     bool prefetch);
+  void handleLevelSet(const QString &node,
+                      const QString &level,
+                      bool success,
+                      const QString &error);
+  void handleMatchingLevelSet(int request_id,
+                              const QString &node,
+                              const QString &level,
+                              int logger_count,
+                              bool success,
+                              const QString &error);
+
+ private:
+  /**
+   * Used by callService() to actually call the service in another thread.
+   */
+  template <class T>
+  static void callServiceWorker(ros::ServiceClient client, T* service, bool* success)
+  {
+    *success = client.call(*service);
+  }
+
+  struct CacheEntry
+  {
+    QStringList names;
+    QStringList levels;
+    QElapsedTimer age;
+  };
+
+  std::map<QString, CacheEntry> cache_;
+  std::set<QString> pending_fetches_;
+  QThreadPool pool_;
+  int last_request_id_;
+
+  QThreadPool prefetch_pool_;
+  QString prefetch_node_;
+  CancelToken prefetch_token_;
+};  // class LoggerService
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_LOGGER_SERVICE_H_
@@ -31,76 +31,71 @@
 #ifndef SWRI_CONSOLE_NODE_CLICK_HANDLER_H
 #define SWRI_CONSOLE_NODE_CLICK_HANDLER_H
 
+#include <string>
 #include <vector>
 
-#include <boost/thread.hpp>
-
 #include <QContextMenuEvent>
 #include <QObject>
 #include <QEvent>
-#include <QFuture>
 #include <QListView>
 #include <QMenu>
-
-#include <ros/ros.h>
-#include <ros/service_client.h>
+#include <QPointer>
+#include <QStringList>
 
 namespace swri_console
 {
+  class LoggerService;
+
   class NodeClickHandler : public QObject
   {
     Q_OBJECT
 
+  public:
+    explicit NodeClickHandler(QObject* parent = NULL);
+
+    /**
+     * Called when the node selection changes.  If a single node is selected,
+     * starts fetching its logger list in the background so that its context
+     * menu can be filled in without waiting.  Otherwise any prefetch that
+     * hasn't started is dropped.
+     */
+    void prefetchLoggers(const std::vector<std::string>& nodes);
+
   public Q_SLOTS:
     void logLevelClicked();
+    void bulkLogLevelClicked();
 
   protected:
     bool eventFilter(QObject* obj, QEvent* event);
 
-  private:
-    /**
-     * Used by callService() to actually call the service in another thread.
-     */
-    template <class T> void callServiceWorker(ros::ServiceClient& client, T* service, bool* success)
-    {
-      *success = client.call(*service);
-    }
-
-    /**
-     * Attempts to call a ROS service.  Will time out and return false if the service call
-     * does not return within a specified time.
-     *
-     * This is *so* ugly, but some sort of hack like this is necessary for keeping the UI responsive;
-     * ROS service clients do not have any built-in timeout mechanism, so we have to wrap our own
-     * around the service call.  If we don't, a call to a hanged node could spin forever.
-     * @tparam T Type of the ROS service
-     * @param client An initialized ros::ServiceClient
-     * @param service An instance of the ROS service
-     * @param timeout_secs The number of seconds to wait before timing out
-     * @return true if the service call completed successfully, otherwise false
-     */
-    template <class T> bool callService(ros::ServiceClient& client, T& service, int timeout_secs = 5)
-    {
-      bool success = false;
-      boost::thread svc_thread(&NodeClickHandler::callServiceWorker<T>, this, client, &service, &success);
-
-      if (svc_thread.try_join_for(boost::chrono::seconds(timeout_secs))) {
-        return success;
-      }
-      svc_thread.interrupt();
-      return false;
-    }
+  private Q_SLOTS:
+    void handleLoggersReceived(const QString& node,
+                               const QStringList& names,
+                               const QStringList& levels);
+    void handleLoggersFailed(const QString& node, const QString& error);
+    void handleLoggerLevelSet(const QString& node,
+                              const QString& level,
+                              bool success,
+                              const QString& error);
 
+  private:
     bool showContextMenu(QListView* list, QContextMenuEvent* event);
-    QMenu* createMenu(const QString& logger_name, const QString& current_level);
+    void showBulkMenu(QListView* list, QContextMenuEvent* event);
+    void populateMenu(const QStringList& names, const QStringList& levels);
+    QMenu* createMenu(QMenu* parent, const QString& logger_name, const QString& current_level);
 
-    ros::NodeHandle nh_;
+    LoggerService* logger_service_;
+    // The context menu that is currently open, if any, and the placeholder
+    // item it shows until the node's loggers arrive.
+    QPointer<QMenu> menu_;
+    QPointer<QAction> loading_action_;
     std::string node_name_;
-    std::vector<std::string> all_loggers_;
+    QStringList all_loggers_;
+    // Nodes targeted by the bulk menu and the last logger pattern entered.
+    QStringList bulk_nodes_;
+    QString bulk_pattern_;
 
     static const std::string ALL_LOGGERS;
-    static const std::string GET_LOGGERS_SVC;
-    static const std::string SET_LOGGER_LEVEL_SVC;
   };
 }
 
@@ -31,10 +31,11 @@
 #ifndef SWRI_CONSOLE_NODE_LIST_MODEL_H_
 #define SWRI_CONSOLE_NODE_LIST_MODEL_H_
 
+#include <stdint.h>
 #include <string>
 #include <vector>
-#include <map>
 #include <QAbstractListModel>
+#include <QTimer>
 
 namespace swri_console
 {
@@ -54,16 +55,48 @@ class NodeListModel : public QAbstractListModel
 
  public Q_SLOTS:
   void clear();
+  // Orders the nodes by message rate, busiest first, instead of by
+  // name.  The order is checked every second.
+  void setSortByRate(bool sort_by_rate);
                                                                  
  private Q_SLOTS:
   void handleDatabaseCleared();
   void handleMessagesAdded();
+  // Redraws the rows whose displayed rates have decayed and, when
+  // sorting by rate, reorders the rows.
+  void refreshRows();
   
  private:
+  struct Row
+  {
+    std::string name;
+    // The node's ID in the database, or NO_NODE if it has not logged
+    // since the database was cleared (which reassigns IDs).
+    uint32_t node_id;
+    // The rate as of the last refreshRows().
+    double rate;
+  };
+  struct RowOrder;
+  static const uint32_t NO_NODE = 0xFFFFFFFF;
+
+  void addNode(uint32_t node_id);
+  void insertNode(uint32_t node_id);
+  // Updates the rows' rates and returns the range of rows whose
+  // displayed rates changed in first and last (-1 if none did).
+  void updateRates(int *first, int *last);
+  // Sorts the rows if they are out of order, and returns true if they
+  // were.
+  bool sortRows();
+
   LogDatabase *db_;
-  
-  std::map<std::string, size_t> data_;
-  std::vector<std::string> ordering_;
+  bool sort_by_rate_;
+  QTimer sort_timer_;
+
+  // Nodes in display order.  Rows are kept by name so that they
+  // survive clearing the database.
+  std::vector<Row> ordering_;
+  // Row of each node ID, or -1 if it isn't listed.
+  std::vector<int> rows_;
 };
 }  // namespace swri_console
 #endif  // SWRI_CONSOLE_NODE_LIST_MODEL_H_
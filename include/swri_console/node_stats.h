@@ -0,0 +1,102 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_NODE_STATS_H_
+#define SWRI_CONSOLE_NODE_STATS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ros/time.h>
+
+namespace swri_console
+{
+struct LogEntry;
+
+/**
+ * Running statistics of one node's messages: counts by severity, the
+ * stamp of its newest message, and an exponentially weighted moving
+ * average of its message rate.  Entries are counted as they are added
+ * and folded into the rate once per batch by updateRate().
+ */
+class NodeStats
+{
+ public:
+  NodeStats();
+
+  /**
+   * Counts an entry.  The rate isn't updated until updateRate().
+   */
+  void add(const LogEntry &entry);
+  /**
+   * Counts messages that the rate limiter kept out of the log toward
+   * the rate, so that a limited node still shows its real rate.
+   */
+  void addSuppressed(size_t count, const ros::Time &stamp);
+  /**
+   * Returns true if entries were added since the last updateRate().
+   */
+  bool hasPending() const { return pending_ != 0; }
+  /**
+   * Folds the messages added since the last call into the rate.
+   */
+  void updateRate();
+
+  /**
+   * Returns the number of entries, or the number at one severity level.
+   */
+  size_t count() const { return count_; }
+  size_t levelCount(uint8_t level) const;
+  const ros::Time& lastSeen() const { return last_seen_; }
+  /**
+   * Returns the message rate, in messages per second, as of a time.
+   * The rate decays while the node is quiet.
+   */
+  double rate(const ros::Time &now) const;
+
+  /**
+   * Whether the node's newest messages came from a live source, which
+   * decides what "now" is for its rate (see LogDatabase::nodeRate()).
+   */
+  void setLive(bool live) { live_ = live; }
+  bool isLive() const { return live_; }
+
+ private:
+  size_t count_;
+  // Indexed by log2 of the rosgraph_msgs::Log level.
+  size_t level_counts_[5];
+  size_t pending_;
+  double rate_;
+  ros::Time rate_stamp_;
+  ros::Time last_seen_;
+  bool live_;
+};  // class NodeStats
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_NODE_STATS_H_
@@ -0,0 +1,166 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_RATE_LIMITER_H_
+#define SWRI_CONSOLE_RATE_LIMITER_H_
+
+#include <stdint.h>
+#include <set>
+#include <vector>
+
+#include <ros/time.h>
+
+#include <boost/unordered_map.hpp>
+
+namespace swri_console
+{
+/**
+ * Token-bucket rate limits per node and per source location (file and
+ * line), applied as messages are added to the LogDatabase.  Rates are
+ * measured against the messages' own stamps, so a bag file is limited
+ * the same way as the live messages it recorded.
+ *
+ * Messages over a limit are counted instead of stored.  The counts are
+ * collected with takeSummaries() so that the database can store one
+ * summary entry per interval in place of the suppressed messages.
+ * WARN and more severe messages are never suppressed and don't use any
+ * tokens.
+ */
+class RateLimiter
+{
+ public:
+  // Messages suppressed by one bucket since its last summary.
+  struct Suppression
+  {
+    uint32_t node_id;
+    // Set for per-location limits.
+    bool by_location;
+    uint32_t file_id;
+    uint32_t line;
+    // The highest severity level that was suppressed.
+    uint8_t level;
+    size_t count;
+    // Stamp of the last suppressed message.
+    ros::Time stamp;
+
+    Suppression() :
+      node_id(0), by_location(false), file_id(0), line(0), level(0), count(0)
+    {
+    }
+  };
+
+  RateLimiter();
+
+  /**
+   * Sets the sustained rate (messages per second) and burst size of
+   * each node's bucket.  A rate of 0 disables the limit.
+   */
+  void setNodeLimit(double rate, double burst);
+  /**
+   * Sets the sustained rate and burst size of each file:line bucket.
+   * A rate of 0 disables the limit.
+   */
+  void setLocationLimit(double rate, double burst);
+
+  /**
+   * Returns true if a message may be stored.  Otherwise the message is
+   * counted in the summary of the bucket that rejected it.  Messages
+   * should be passed in the order they arrive; their stamps may go
+   * backwards (e.g. when a second bag file is loaded).
+   */
+  bool accept(uint32_t node_id,
+              uint32_t file_id,
+              uint32_t line,
+              uint8_t level,
+              const ros::Time &stamp);
+
+  /**
+   * Moves the limiter's current time forward to now, if it is later
+   * than the newest stamp seen.  Summaries of a source whose messages
+   * have stopped would otherwise wait for the next message.
+   */
+  void advanceTo(const ros::Time &now);
+
+  /**
+   * Appends the summaries that are due (SUMMARY_INTERVAL has passed
+   * since the bucket's previous summary), or every pending summary if
+   * force is true, and resets their counts.
+   */
+  void takeSummaries(bool force, std::vector<Suppression> *summaries);
+
+  /**
+   * Forgets all buckets and pending counts.
+   */
+  void clear();
+
+ private:
+  struct Limit
+  {
+    double rate;
+    double burst;
+
+    Limit() : rate(0.0), burst(0.0) {}
+    bool enabled() const { return rate > 0.0; }
+  };
+
+  struct Bucket
+  {
+    bool started;
+    double tokens;
+    ros::Time last_refill;
+    ros::Time last_summary;
+    Suppression suppressed;
+
+    Bucket() : started(false), tokens(0.0) {}
+  };
+
+  static uint64_t locationKey(uint32_t file_id, uint32_t line)
+  {
+    return (static_cast<uint64_t>(file_id) << 32) | line;
+  }
+
+  static void refill(Bucket &bucket, const Limit &limit, const ros::Time &stamp);
+  static void suppress(Bucket &bucket, uint8_t level, const ros::Time &stamp);
+  bool takeSummary(Bucket &bucket, bool force, std::vector<Suppression> *summaries);
+
+  Limit node_limit_;
+  Limit location_limit_;
+  // Indexed by node ID.
+  std::vector<Bucket> node_buckets_;
+  boost::unordered_map<uint64_t, Bucket> location_buckets_;
+  // Buckets with suppressed messages that haven't been summarized.
+  std::set<uint32_t> pending_nodes_;
+  std::set<uint64_t> pending_locations_;
+  // The latest stamp seen (or time passed to advanceTo()), which is the
+  // current time for summaries.
+  ros::Time latest_;
+};  // class RateLimiter
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_RATE_LIMITER_H_
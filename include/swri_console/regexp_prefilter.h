@@ -0,0 +1,90 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_REGEXP_PREFILTER_H_
+#define SWRI_CONSOLE_REGEXP_PREFILTER_H_
+
+#include <vector>
+
+#include <QRegExp>
+#include <QStringList>
+#include <QStringMatcher>
+
+namespace swri_console
+{
+/**
+ * Quickly rejects text that can't match a regular expression.
+ *
+ * Most filter patterns are literals with a little structure, e.g.
+ * "timeout.*socket" can only match text that contains both "timeout"
+ * and "socket".  The prefilter extracts the literals that every match
+ * must contain and looks for them with QStringMatcher, which is much
+ * cheaper than running the regular expression.  Only text that
+ * contains all of the literals needs to be checked with the regexp.
+ *
+ * The extraction is conservative: patterns it doesn't understand (for
+ * example, alternations at the top level) just produce fewer literals.
+ */
+class RegExpPrefilter
+{
+ public:
+  RegExpPrefilter();
+
+  /**
+   * Extracts the required literals of a regexp.
+   */
+  void setRegExp(const QRegExp &regexp);
+
+  /**
+   * Returns false if the text certainly doesn't match the regexp, and
+   * true if it might.
+   */
+  bool mayMatch(const QString &text) const
+  {
+    for (size_t i = 0; i < matchers_.size(); i++) {
+      if (matchers_[i].indexIn(text) < 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Returns the literals that every match must contain.
+   */
+  QStringList literals() const;
+
+ private:
+  // Ordered from the longest literal to the shortest, since longer
+  // literals are usually rarer and reject more text.
+  std::vector<QStringMatcher> matchers_;
+};  // class RegExpPrefilter
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_REGEXP_PREFILTER_H_
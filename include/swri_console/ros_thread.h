@@ -37,6 +37,8 @@
 #include <rosgraph_msgs/Log.h>
 #include <QMetaType>
 
+#include <swri_console/ingest_source.h>
+
 namespace swri_console
 {
   class RosThread : public QThread
@@ -49,16 +51,17 @@ namespace swri_console
      */
     void shutdown();
 
+    /**
+     * The source that delivers the messages received on /rosout_agg.  A batch is sent after
+     * every spin of the ROS core.
+     */
+    IngestSource* source() { return &source_; }
+
   Q_SIGNALS:
     /**
      * Emitted every time we are successfully connected to or disconnected from ROS.
      */
     void connected(bool);
-    /**
-     * Emitted every time a log message is received.  This can be emitted multiple times per spin of
-     * the ROS core; wait until spun() is emitted to do any processing on them.
-     */
-    void logReceived(const rosgraph_msgs::LogConstPtr &msg);
     /**
      * Emitted after every time ros::spinOnce() completes.
      */
@@ -75,6 +78,7 @@ namespace swri_console
     bool is_connected_;
     volatile bool is_running_;
     ros::Subscriber rosout_sub_;
+    IngestSource source_;
   };
 }
 
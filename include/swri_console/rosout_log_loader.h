@@ -37,32 +37,61 @@
 
 #include <rosgraph_msgs/Log.h>
 
+#include <swri_console/ingest_source.h>
+#include <swri_console/task_executor.h>
+
 namespace swri_console
 {
+  class LogDatabase;
+
   class RosoutLogLoader : public QObject
   {
     Q_OBJECT
   public:
-    void loadRosLog(const QString& filename);
-    void loadRosLogDirectory(const QString& logdirectory_name);
-
-  public Q_SLOTS:
-    void promptForLogFile();
-    void promptForLogDirectory();
+    /**
+     * @param[in] executor Files and directories picked with the prompts are loaded as
+     *                     BULK tasks on this executor.
+     * @param[in] db       Each file or directory is loaded through its own IngestSource,
+     *                     which is added to this database for the duration of the load.
+     */
+    RosoutLogLoader(TaskExecutor* executor, LogDatabase* db);
 
-  Q_SIGNALS:
     /**
-     * Emitted every time a log message is received.  This will likely be emitted several times
-     * per bag file; finishedReading will be emitted when we're done.
+     * Sets the memory budget given to the source of each load.
      */
-    void logReceived(const rosgraph_msgs::LogConstPtr& msg);
+    void setMemoryBudget(qint64 bytes) { memory_budget_ = bytes; }
+
+    // These load into the source on the calling thread and stop early if the token is
+    // cancelled.  Each call is reported with the source's lifecycle signals, using the
+    // file or directory name as the description.
+    void loadRosLog(IngestSource* source,
+                    const QString& filename,
+                    const CancelToken& token = CancelToken());
+    void loadRosLogDirectory(IngestSource* source,
+                             const QString& logdirectory_name,
+                             const CancelToken& token = CancelToken());
 
     /**
-     * Emitted after we're completely done reading the bag file.
+     * Stops loading any files that are being loaded in the background.
      */
-    void finishedReading();
+    void cancel();
+
+  public Q_SLOTS:
+    void promptForLogFile();
+    void promptForLogDirectory();
+
+  private Q_SLOTS:
+    // Removes a load's source from the database once its task is done.
+    void finishLoad(QObject* source);
 
   private:
+    TaskExecutor* executor_;
+    LogDatabase* db_;
+    qint64 memory_budget_;
+    CancelToken cancel_token_;
+
+    void submitLoad(const QString& path, bool is_directory);
+    bool loadFile(IngestSource* source, const QString& filename, const CancelToken& token);
     int parseLine(std::string line, int seq, rosgraph_msgs::Log* log);
     rosgraph_msgs::Log::_level_type level_string_to_level_type(std::string level_str);
   };
@@ -0,0 +1,125 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_SEARCH_RESULTS_MODEL_H_
+#define SWRI_CONSOLE_SEARCH_RESULTS_MODEL_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QMutex>
+#include <QString>
+
+#include <boost/shared_ptr.hpp>
+
+#include <swri_console/task_executor.h>
+
+namespace swri_console
+{
+class LogDatabase;
+class LogDatabaseProxyModel;
+
+// Log indices of matching entries, in increasing order.
+typedef std::vector<size_t> SearchMatches;
+
+/**
+ * Lists every entry of a LogDatabaseProxyModel's current view that
+ * contains a search text, with some of the surrounding text for
+ * context.
+ *
+ * Large scans are split into chunks that are searched in parallel as
+ * interactive tasks on the shared executor.  Each task reads a snapshot
+ * of the log and posts its matches back to the GUI thread, where they
+ * are added to the list as they arrive.  The results are kept up to
+ * date as the proxy model inserts rows; a new search or a reset of the
+ * proxy model cancels the outstanding tasks and starts over.
+ */
+class SearchResultsModel : public QAbstractListModel
+{
+  Q_OBJECT
+
+ public:
+  SearchResultsModel(LogDatabase *db,
+                     LogDatabaseProxyModel *proxy,
+                     TaskExecutor *executor,
+                     QObject *parent = NULL);
+  ~SearchResultsModel();
+
+  /**
+   * Finds every entry containing the text (case insensitive).  An
+   * empty text clears the results.
+   */
+  void setSearchText(const QString &text);
+
+  /**
+   * Returns the log index of the entry listed at a row.
+   */
+  size_t logIndex(int row) const { return matches_[row]; }
+
+  virtual int rowCount(const QModelIndex &parent) const;
+  virtual QVariant data(const QModelIndex &index, int role) const;
+
+ Q_SIGNALS:
+  // Emitted from the worker threads with the matches of one chunk of a
+  // search.  Results from an earlier search are ignored.
+  void matchesFound(quint64 search_id, const swri_console::SearchMatches &matches);
+
+ private Q_SLOTS:
+  void handleRowsInserted(const QModelIndex &parent, int first, int last);
+  void handleModelReset();
+  void handleMatchesFound(quint64 search_id, const swri_console::SearchMatches &matches);
+
+ private:
+  void findAll();
+  // Searches the entries shown in the given rows of the proxy model for
+  // the search text.  The matches are added now if there are only a
+  // few rows, or as the background tasks finish otherwise.
+  void findMatches(int first_row, int last_row);
+  // Adds matches that aren't already listed.
+  void addMatches(const SearchMatches &matches);
+
+  LogDatabase *db_;
+  LogDatabaseProxyModel *proxy_;
+  TaskExecutor *executor_;
+  QString search_text_;
+  SearchMatches matches_;
+
+  // Identifies the current search.  It changes whenever the results
+  // are reset, along with the token that cancels the previous search's
+  // tasks.
+  quint64 search_id_;
+  CancelToken cancel_token_;
+  // Held by the tasks while they emit matchesFound(), so that once the
+  // destructor has cancelled the token under it, no task can emit.
+  boost::shared_ptr<QMutex> emit_mutex_;
+};  // class SearchResultsModel
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_SEARCH_RESULTS_MODEL_H_
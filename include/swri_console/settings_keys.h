@@ -49,6 +49,7 @@ namespace swri_console
     static const QString DISPLAY_LOGGER;
     static const QString DISPLAY_FUNCTION;
     static const QString USE_REGEXPS;
+    static const QString USE_QUERY_LANGUAGE;
     static const QString INCLUDE_FILTER;
     static const QString EXCLUDE_FILTER;
     static const QString SHOW_DEBUG;
@@ -65,6 +66,14 @@ namespace swri_console
     static const QString FATAL_COLOR;
     static const QString COLORIZE_LOGS;
     static const QString ALTERNATE_LOG_ROW_COLORS;
+    static const QString SHOW_DETAILS;
+    static const QString SORT_NODES_BY_RATE;
+    static const QString INGEST_MEMORY_BUDGET_MB;
+    static const QString INGEST_SHEDDING_THRESHOLD_MB;
+    static const QString NODE_RATE_LIMIT;
+    static const QString NODE_BURST;
+    static const QString LOCATION_RATE_LIMIT;
+    static const QString LOCATION_BURST;
   };
 }
 
@@ -0,0 +1,96 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_STRING_TABLE_H_
+#define SWRI_CONSOLE_STRING_TABLE_H_
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace swri_console
+{
+/**
+ * Maps strings to small, dense integer IDs.  Log fields such as node,
+ * file and function names repeat constantly, so entries store the ID of
+ * the interned value instead of their own copy.  IDs are assigned in
+ * order starting at zero, which lets callers cache per-value results in
+ * vectors indexed by ID.  IDs are only valid until the table is
+ * cleared, so such caches should also record the generation() they
+ * were built for and start over when it changes.
+ *
+ * Copies share their values until one of them is changed, so copying a
+ * table to hand it to another thread is cheap.  A copy can be read on
+ * another thread while the original keeps interning on its own.
+ */
+class StringTable
+{
+ public:
+  StringTable();
+
+  /**
+   * Returns the ID of a value, adding it to the table if necessary.
+   */
+  uint32_t intern(const std::string &value);
+
+  /**
+   * Returns the value of an ID that was returned by intern().
+   */
+  const std::string& value(uint32_t id) const { return data_->values[id]; }
+
+  /**
+   * Returns the number of distinct values, which is also one more than
+   * the largest ID.
+   */
+  size_t size() const { return data_->values.size(); }
+
+  /**
+   * Removes every value and advances the generation.  IDs are
+   * reassigned from zero afterwards.
+   */
+  void clear();
+  uint32_t generation() const { return generation_; }
+
+ private:
+  struct Data
+  {
+    // A deque keeps references to the values stable as the table grows.
+    std::deque<std::string> values;
+    boost::unordered_map<std::string, uint32_t> ids;
+  };
+
+  boost::shared_ptr<Data> data_;
+  uint32_t generation_;
+};  // class StringTable
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_STRING_TABLE_H_
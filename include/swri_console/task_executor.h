@@ -0,0 +1,170 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_TASK_EXECUTOR_H_
+#define SWRI_CONSOLE_TASK_EXECUTOR_H_
+
+#include <stddef.h>
+#include <deque>
+#include <vector>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRunnable>
+#include <QWaitCondition>
+
+#include <boost/shared_ptr.hpp>
+
+namespace swri_console
+{
+/**
+ * A flag shared between the code that starts a background job and the
+ * job itself.  Copies refer to the same flag.  Long-running tasks
+ * should check isCancelled() periodically and return early.
+ */
+class CancelToken
+{
+ public:
+  CancelToken();
+
+  void cancel();
+  bool isCancelled() const;
+
+ private:
+  boost::shared_ptr<QAtomicInt> cancelled_;
+};  // class CancelToken
+
+/**
+ * A work-stealing thread pool shared by all background jobs.
+ *
+ * Each worker thread has its own queues.  Tasks submitted from a worker
+ * go to that worker's queues and are run newest first; other tasks are
+ * spread across the workers.  A worker whose queues are empty steals
+ * the oldest task from another worker.
+ *
+ * INTERACTIVE tasks (work the user is waiting on, like searches) always
+ * run before BULK tasks (loading files, building indices).  BULK tasks
+ * are also limited to all but one of the threads so that interactive
+ * work never waits behind a long load.
+ *
+ * RECLAIM tasks (compressing and freeing old data) are short and give
+ * memory back, which is what a loader waiting on its memory budget
+ * needs.  They run after INTERACTIVE tasks and before BULK tasks, and
+ * aren't limited by the BULK cap, so loaders that hold every BULK
+ * thread can't hold up the work that lets them continue.
+ */
+class TaskExecutor
+{
+ public:
+  enum Priority
+  {
+    INTERACTIVE = 0,
+    BULK = 1,
+    RECLAIM = 2
+  };
+
+  /**
+   * Creates the executor's threads.  A thread_count of 0 uses one
+   * thread per core.
+   */
+  explicit TaskExecutor(int thread_count = 0);
+  ~TaskExecutor();
+
+  int threadCount() const { return static_cast<int>(workers_.size()); }
+
+  /**
+   * Queues a task to run on a worker thread.  The executor deletes the
+   * task after it runs if task->autoDelete() is true.  If the token is
+   * cancelled before the task starts, the task is dropped without
+   * running.
+   */
+  void submit(QRunnable *task, Priority priority, const CancelToken &token = CancelToken());
+
+  /**
+   * Moves the caller's reference to an object into a RECLAIM task and
+   * resets the caller's pointer.  If that was the last reference, the
+   * object is destroyed on a worker thread, so tearing down a large
+   * structure doesn't block the caller.
+   */
+  template <class T>
+  void release(boost::shared_ptr<T> &object)
+  {
+    QRunnable *task = createReleaseTask(boost::shared_ptr<const void>(object));
+    object.reset();
+    submit(task, RECLAIM);
+  }
+
+  /**
+   * Stops the worker threads after their current tasks finish and drops
+   * any queued tasks.  Called automatically by the destructor.
+   */
+  void shutdown();
+
+ private:
+  class Worker;
+
+  struct QueuedTask
+  {
+    QRunnable *task;
+    CancelToken token;
+  };
+
+  static const size_t NUM_PRIORITIES = 3;
+
+  struct WorkQueue
+  {
+    QMutex mutex;
+    std::deque<QueuedTask> tasks[NUM_PRIORITIES];
+  };
+
+  static QRunnable* createReleaseTask(const boost::shared_ptr<const void> &object);
+  int currentWorker() const;
+  bool reserveTask(Priority *priority);
+  bool takeTask(size_t worker, Priority priority, QueuedTask *task);
+  void runWorker(size_t worker);
+  static void finishTask(const QueuedTask &task, bool run);
+
+  std::vector<WorkQueue*> queues_;
+  std::vector<Worker*> workers_;
+  QAtomicInt next_queue_;
+
+  // Guards the counters below and is used with wake_ to put idle
+  // workers to sleep.
+  QMutex mutex_;
+  QWaitCondition wake_;
+  // Number of queued tasks of each priority that no worker has
+  // reserved yet.
+  size_t pending_[NUM_PRIORITIES];
+  size_t running_bulk_;
+  size_t max_bulk_;
+  bool stopping_;
+};  // class TaskExecutor
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_TASK_EXECUTOR_H_
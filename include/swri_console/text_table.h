@@ -0,0 +1,120 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#ifndef SWRI_CONSOLE_TEXT_TABLE_H_
+#define SWRI_CONSOLE_TEXT_TABLE_H_
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <QStringList>
+
+#include <boost/unordered_map.hpp>
+
+namespace swri_console
+{
+class TaskExecutor;
+
+/**
+ * Content-addressed storage for message bodies.  Many messages repeat
+ * the same text (heartbeats, "waiting for transform", ...), so each
+ * distinct body is split into lines once and stored once; entries with
+ * the same text share the stored QStringList through Qt's implicit
+ * sharing and carry its ID.  Like StringTable, IDs are dense and
+ * start at zero, so filters can cache a verdict per distinct text in a
+ * vector indexed by ID, and the table has a generation() that changes
+ * when it is cleared and the IDs are reused.
+ *
+ * The table only holds bodies that are in use by uncompressed entries.
+ * Each intern() counts a use, and once every use has been release()d
+ * (because the entries were compressed into a chunk that carries its
+ * own copy) the body is dropped and its ID is reused for the next new
+ * body, so the IDs stay as dense as the live bodies.  Compressed entries
+ * still carry the old ID, so each ID also has a version that changes
+ * when it is reused; caches indexed by ID must compare the version too.
+ */
+class TextTable
+{
+ public:
+  TextTable();
+
+  /**
+   * Returns the ID of a message body, adding it to the table if
+   * necessary.
+   */
+  uint32_t intern(const std::string &text);
+
+  /**
+   * Releases one use of a body counted by intern().
+   */
+  void release(uint32_t id);
+
+  /**
+   * Returns the lines of a body that was added by intern() and has not
+   * been released since.
+   */
+  const QStringList& value(uint32_t id) const { return values_[id]; }
+
+  /**
+   * Returns the version of an ID, which changes each time the ID is
+   * reused for a new body.
+   */
+  uint32_t version(uint32_t id) const { return versions_[id]; }
+
+  /**
+   * Returns one more than the largest ID.  IDs of released bodies are
+   * counted until they are reused.
+   */
+  size_t size() const { return values_.size(); }
+
+  /**
+   * Removes every body and advances the generation.  IDs are reassigned
+   * from zero afterwards.  The old bodies are handed to the executor to
+   * be freed in the background (or freed here if executor is NULL).
+   */
+  void clear(TaskExecutor *executor);
+  uint32_t generation() const { return generation_; }
+
+ private:
+  std::deque<QStringList> values_;
+  // Bodies are looked up by the hash of their text, so the table
+  // doesn't need to keep a second copy of each body as a key.
+  boost::unordered_multimap<uint, uint32_t> ids_;
+  // Number of unreleased uses of each body.
+  std::deque<uint32_t> uses_;
+  std::deque<uint32_t> versions_;
+  // IDs of released bodies, to be reused.
+  std::vector<uint32_t> free_ids_;
+  uint32_t generation_;
+};  // class TextTable
+}  // namespace swri_console
+#endif  // SWRI_CONSOLE_TEXT_TABLE_H_
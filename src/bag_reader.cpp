@@ -30,19 +30,83 @@
 
 #include <QFileDialog>
 #include <QDir>
+#include <QRunnable>
 
 #include "include/swri_console/bag_reader.h"
+#include <swri_console/log_database.h>
 
 #include <rosbag/bag.h>
 #include <rosbag/view.h>
 
 using namespace swri_console;
 
-void BagReader::readBagFile(const QString& filename)
+namespace
 {
+  class ReadBagTask : public QRunnable
+  {
+  public:
+    ReadBagTask(BagReader* reader,
+                IngestSource* source,
+                const QString& filename,
+                const CancelToken& token) :
+      reader_(reader),
+      source_(source),
+      filename_(filename),
+      token_(token)
+    {
+    }
+
+    ~ReadBagTask()
+    {
+      // The executor deletes the task even if it was cancelled before it ran, so the
+      // source is always removed.  This is queued behind the source's last batch.
+      QMetaObject::invokeMethod(reader_, "finishRead", Qt::QueuedConnection,
+                                Q_ARG(QObject*, source_));
+    }
+
+    void run()
+    {
+      reader_->readBagFile(source_, filename_, token_);
+    }
+
+  private:
+    BagReader* reader_;
+    IngestSource* source_;
+    QString filename_;
+    CancelToken token_;
+  };
+}
+
+BagReader::BagReader(TaskExecutor* executor, LogDatabase* db) :
+  executor_(executor),
+  db_(db),
+  memory_budget_(0)
+{
+}
+
+void BagReader::cancel()
+{
+  cancel_token_.cancel();
+  cancel_token_ = CancelToken();
+}
+
+void BagReader::readBagFile(IngestSource* source,
+                            const QString& filename,
+                            const CancelToken& token)
+{
+  emit source->started(filename);
+
   bool log_messages_found = true;
   rosbag::Bag bag;
-  bag.open(filename.toStdString(), rosbag::bagmode::Read);
+  try
+  {
+    bag.open(filename.toStdString(), rosbag::bagmode::Read);
+  }
+  catch (const rosbag::BagException& e)
+  {
+    emit source->error(filename, QString::fromStdString(e.what()));
+    return;
+  }
 
   rosbag::View view(bag, rosbag::TopicQuery("/rosout"));
   if (view.size() == 0)
@@ -60,20 +124,31 @@ void BagReader::readBagFile(const QString& filename)
   if (log_messages_found)
   {
     rosbag::View::const_iterator iter;
+    const size_t total = view.size();
+    size_t count = 0;
+    int percent = 0;
 
-    for(iter = view.begin(); iter != view.end(); ++iter)
+    for(iter = view.begin(); iter != view.end() && !token.isCancelled(); ++iter)
     {
       rosgraph_msgs::LogConstPtr log = iter->instantiate<rosgraph_msgs::Log>();
       if (log != NULL ) {
-        emit logReceived(log);
+        source->addMessage(log, token);
       }
       else {
         qWarning("Got a message that was not a log message but a: %s", iter->getDataType().c_str());
       }
+
+      count++;
+      if (count * 100 / total > static_cast<size_t>(percent))
+      {
+        percent = count * 100 / total;
+        emit source->progress(filename, percent);
+      }
     }
   }
 
-  emit finishedReading();
+  source->flush();
+  emit source->finished(filename);
 }
 
 void BagReader::promptForBagFile()
@@ -85,6 +160,19 @@ void BagReader::promptForBagFile()
 
   if (filename != NULL)
   {
-    readBagFile(filename);
+    // Each read gets its own source so that reads running at the same time don't share
+    // batches, a memory budget or rate limits.
+    IngestSource* source = new IngestSource(this);
+    source->setMemoryBudget(memory_budget_);
+    db_->addSource(source);
+    executor_->submit(new ReadBagTask(this, source, filename, cancel_token_),
+                      TaskExecutor::BULK,
+                      cancel_token_);
   }
 }
+
+void BagReader::finishRead(QObject* source)
+{
+  db_->removeSource(static_cast<IngestSource*>(source));
+  delete source;
+}
@@ -30,6 +30,7 @@
 
 #include <swri_console/console_master.h>
 #include <swri_console/console_window.h>
+#include <swri_console/search_results_model.h>
 #include <swri_console/settings_keys.h>
 
 #include <QFontDialog>
@@ -37,36 +38,77 @@
 
 namespace swri_console
 {
+// Default limit on the messages a file loader can have queued for the
+// database, in megabytes.
+static const int DEFAULT_INGEST_MEMORY_BUDGET_MB = 256;
+// Default backlog of the live ROS subscription, in megabytes, at which
+// it starts dropping DEBUG and INFO messages.
+static const int DEFAULT_INGEST_SHEDDING_THRESHOLD_MB = 32;
+// Default rate limits, in messages per second, and burst sizes.  Both
+// limits are off unless configured, since dropping messages by default
+// would surprise users.
+static const double DEFAULT_NODE_RATE_LIMIT = 0.0;
+static const double DEFAULT_NODE_BURST = 5000.0;
+static const double DEFAULT_LOCATION_RATE_LIMIT = 0.0;
+static const double DEFAULT_LOCATION_BURST = 100.0;
+
 ConsoleMaster::ConsoleMaster(int argc, char** argv):
+  bag_reader_(&executor_, &db_),
+  log_reader_(&executor_, &db_),
   ros_thread_(argc, argv),
   connected_(false),
+  db_(&executor_),
   window_font_(QFont("Ubuntu Mono", 9))
 {
-  // The RosThread takes advantage of queued connections when emitting log messages
+  // The ingest sources take advantage of queued connections when emitting log messages
   // to ensure that the messages are processed in the console window's event thread.
-  // In order for that to work, we have to manually register the message type with
+  // In order for that to work, we have to manually register the message types with
   // Qt's QMetaType system.
   qRegisterMetaType<rosgraph_msgs::LogConstPtr>("rosgraph_msgs::LogConstPtr");
+  qRegisterMetaType<swri_console::LogBatch>("swri_console::LogBatch");
+  // Find All posts its matches from worker threads the same way.
+  qRegisterMetaType<swri_console::SearchMatches>("swri_console::SearchMatches");
+
+  ros_thread_.source()->setLive(true);
+  db_.addSource(ros_thread_.source());
 
-  QObject::connect(&bag_reader_, SIGNAL(logReceived(const rosgraph_msgs::LogConstPtr& )),
-                   &db_, SLOT(queueMessage(const rosgraph_msgs::LogConstPtr&) ));
-  QObject::connect(&bag_reader_, SIGNAL(finishedReading()),
-                   &db_, SLOT(processQueue()));
-  QObject::connect(&log_reader_, SIGNAL(logReceived(const rosgraph_msgs::LogConstPtr& )),
-                   &db_, SLOT(queueMessage(const rosgraph_msgs::LogConstPtr&) ));
-  QObject::connect(&log_reader_, SIGNAL(finishedReading()),
-                   &db_, SLOT(processQueue()));
+  // File loaders wait for the database to catch up so that loading a large file
+  // doesn't queue the whole file in memory.  The live ROS source can't wait, so
+  // when it falls behind it drops low-severity messages instead, rather than
+  // leaving roscpp to drop messages of any severity.
+  QSettings settings;
+  qint64 budget_mb = settings.value(SettingsKeys::INGEST_MEMORY_BUDGET_MB,
+                                    DEFAULT_INGEST_MEMORY_BUDGET_MB).toLongLong();
+  bag_reader_.setMemoryBudget(budget_mb * 1024 * 1024);
+  log_reader_.setMemoryBudget(budget_mb * 1024 * 1024);
+  qint64 threshold_mb = settings.value(SettingsKeys::INGEST_SHEDDING_THRESHOLD_MB,
+                                       DEFAULT_INGEST_SHEDDING_THRESHOLD_MB).toLongLong();
+  ros_thread_.source()->setSheddingThreshold(threshold_mb * 1024 * 1024);
+
+  // Keep a single runaway node or log statement from flooding the log.
+  db_.setNodeRateLimit(
+    settings.value(SettingsKeys::NODE_RATE_LIMIT, DEFAULT_NODE_RATE_LIMIT).toDouble(),
+    settings.value(SettingsKeys::NODE_BURST, DEFAULT_NODE_BURST).toDouble());
+  db_.setLocationRateLimit(
+    settings.value(SettingsKeys::LOCATION_RATE_LIMIT, DEFAULT_LOCATION_RATE_LIMIT).toDouble(),
+    settings.value(SettingsKeys::LOCATION_BURST, DEFAULT_LOCATION_BURST).toDouble());
 }
 
 ConsoleMaster::~ConsoleMaster()
 {
   ros_thread_.shutdown();
   ros_thread_.wait();
+
+  // Stop the loaders before the executor's threads are joined, and join
+  // them before the loaders and database they use are destroyed.
+  bag_reader_.cancel();
+  log_reader_.cancel();
+  executor_.shutdown();
 }
 
 void ConsoleMaster::createNewWindow()
 {
-  ConsoleWindow* win = new ConsoleWindow(&db_);
+  ConsoleWindow* win = new ConsoleWindow(&db_, &idle_scheduler_, &executor_);
   windows_.append(win);
 
   QSettings settings;
@@ -78,6 +120,9 @@ void ConsoleMaster::createNewWindow()
   QObject::connect(&ros_thread_, SIGNAL(connected(bool)),
                    win, SLOT(connected(bool)));
 
+  QObject::connect(&db_, SIGNAL(sourceStatus(const QString&)),
+                   win, SLOT(showSourceStatus(const QString&)));
+
   QObject::connect(this,
                    SIGNAL(fontChanged(const QFont &)),
                    win, SLOT(setFont(const QFont &)));
@@ -97,15 +142,8 @@ void ConsoleMaster::createNewWindow()
 
   if (!ros_thread_.isRunning())
   {
-    // There's only one ROS thread, and it services every window.  We need to initialize
-    // it and its connections to the LogDatabase when we first create a window, but
-    // after that it doesn't need to be modified again.
-    QObject::connect(&ros_thread_, SIGNAL(logReceived(const rosgraph_msgs::LogConstPtr& )),
-                     &db_, SLOT(queueMessage(const rosgraph_msgs::LogConstPtr&) ));
-
-    QObject::connect(&ros_thread_, SIGNAL(spun()),
-                     &db_, SLOT(processQueue()));
-
+    // There's only one ROS thread, and it services every window.  We need to start it
+    // when we first create a window, but after that it doesn't need to be modified again.
     ros_thread_.start();
   }
 
@@ -37,9 +37,11 @@
 
 
 #include <swri_console/console_window.h>
+#include <swri_console/field_filter.h>
 #include <swri_console/log_database.h>
 #include <swri_console/log_database_proxy_model.h>
 #include <swri_console/node_list_model.h>
+#include <swri_console/search_results_model.h>
 #include <swri_console/settings_keys.h>
 
 #include <QColorDialog>
@@ -52,18 +54,26 @@
 #include <QScrollBar>
 #include <QMenu>
 #include <QSettings>
+#include <QWindow>
 
 using namespace Qt;
 
 namespace swri_console {
 
-ConsoleWindow::ConsoleWindow(LogDatabase *db)
+// How long to wait after the last edit to a filter box before
+// applying it.
+static const int FILTER_DEBOUNCE_MS = 150;
+
+ConsoleWindow::ConsoleWindow(LogDatabase *db, IdleScheduler *scheduler, TaskExecutor *executor)
   :
   QMainWindow(),
   db_(db),
-  db_proxy_(new LogDatabaseProxyModel(db)),
+  db_proxy_(new LogDatabaseProxyModel(db, scheduler)),
   node_list_model_(new NodeListModel(db)),
-  node_click_handler_(new NodeClickHandler())
+  node_click_handler_(new NodeClickHandler(this)),
+  search_results_(new SearchResultsModel(db, db_proxy_, executor, this)),
+  shed_label_(new QLabel(this)),
+  top_row_before_insert_(-1)
 {
   ui.setupUi(this); 
 
@@ -103,15 +113,19 @@ ConsoleWindow::ConsoleWindow(LogDatabase *db)
   QObject::connect(ui.action_ShowFunctionName, SIGNAL(toggled(bool)),
                    db_proxy_, SLOT(setDisplayFunction(bool)));
 
-  QObject::connect(ui.action_RegularExpressions, SIGNAL(toggled(bool)),
-                   db_proxy_, SLOT(setUseRegularExpressions(bool)));
-
   QObject::connect(ui.action_RegularExpressions, SIGNAL(toggled(bool)),
                    this, SLOT(updateIncludeLabel()));
 
   QObject::connect(ui.action_RegularExpressions, SIGNAL(toggled(bool)),
                    this, SLOT(updateExcludeLabel()));
 
+  // Field terms are only split out of the plain text filters.
+  QObject::connect(ui.action_RegularExpressions, SIGNAL(toggled(bool)),
+                   this, SLOT(applyTextFilters()));
+
+  QObject::connect(ui.action_QueryLanguage, SIGNAL(toggled(bool)),
+                   this, SLOT(applyTextFilters()));
+
   QObject::connect(ui.action_SelectFont, SIGNAL(triggered(bool)),
                    this, SIGNAL(selectFont()));
 
@@ -133,6 +147,19 @@ ConsoleWindow::ConsoleWindow(LogDatabase *db)
   ui.messageList->setModel(db_proxy_);
   ui.messageList->setUniformItemSizes(true);
 
+  ui.detailsText->setVisible(ui.action_ShowDetails->isChecked());
+  QObject::connect(ui.action_ShowDetails, SIGNAL(toggled(bool)),
+                   this, SLOT(setShowDetails(bool)));
+  QObject::connect(ui.action_SortNodesByRate, SIGNAL(toggled(bool)),
+                   this, SLOT(setSortNodesByRate(bool)));
+  QObject::connect(ui.messageList, SIGNAL(doubleClicked(const QModelIndex &)),
+                   this, SLOT(toggleMessageExpanded(const QModelIndex &)));
+  QObject::connect(
+    ui.messageList->selectionModel(),
+    SIGNAL(currentChanged(const QModelIndex &, const QModelIndex &)),
+    this,
+    SLOT(updateDetails()));
+
   QObject::connect(
     ui.nodeList->selectionModel(),
     SIGNAL(selectionChanged(const QItemSelection &,
@@ -162,6 +189,15 @@ ConsoleWindow::ConsoleWindow(LogDatabase *db)
     this, SLOT(messagesAdded()));
   QObject::connect(ui.checkFollowNewest, SIGNAL(toggled(bool)),
                    this, SLOT(setFollowNewest(bool)));
+  QObject::connect(
+    db_proxy_, SIGNAL(rowsAboutToBeInserted(const QModelIndex &, int, int)),
+    this, SLOT(messagesAboutToBeInserted(const QModelIndex &, int, int)));
+  QObject::connect(
+    db_proxy_, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+    this, SLOT(messagesInserted(const QModelIndex &, int, int)));
+  QObject::connect(
+    db_proxy_, SIGNAL(modelReset()),
+    this, SLOT(messagesReset()));
 
   // Right-click menu for the message list
   QObject::connect(ui.messageList, SIGNAL(customContextMenuRequested(const QPoint&)),
@@ -184,6 +220,11 @@ ConsoleWindow::ConsoleWindow(LogDatabase *db)
     ui.excludeText, SIGNAL(textChanged(const QString &)),
     this, SLOT(excludeFilterUpdated(const QString &)));
 
+  filter_timer_.setSingleShot(true);
+  filter_timer_.setInterval(FILTER_DEBOUNCE_MS);
+  QObject::connect(&filter_timer_, SIGNAL(timeout()),
+                   this, SLOT(applyTextFilters()));
+
   // Connect 'Search' text modification to searchIndex, VCM 13 April 2017
   QObject::connect(
     ui.searchText, SIGNAL(textChanged(const QString &)),
@@ -195,6 +236,25 @@ ConsoleWindow::ConsoleWindow(LogDatabase *db)
   QObject::connect(ui.pushNext, SIGNAL(clicked()),
     this, SLOT(nextIndex()));
 
+  ui.searchResultsList->setModel(search_results_);
+  ui.searchResultsList->setVisible(false);
+  QObject::connect(ui.pushFindAll, SIGNAL(toggled(bool)),
+                   this, SLOT(setFindAll(bool)));
+  QObject::connect(ui.searchResultsList, SIGNAL(activated(const QModelIndex &)),
+                   this, SLOT(showSearchResult(const QModelIndex &)));
+  QObject::connect(ui.searchResultsList, SIGNAL(clicked(const QModelIndex &)),
+                   this, SLOT(showSearchResult(const QModelIndex &)));
+
+
+  shed_label_->setToolTip("DEBUG and INFO messages dropped because the console\n"
+                          "couldn't keep up with /rosout_agg.  WARN and above\n"
+                          "are never dropped.");
+  shed_label_->setVisible(false);
+  statusBar()->addPermanentWidget(shed_label_);
+  QObject::connect(db_, SIGNAL(shedCountsChanged()),
+                   this, SLOT(updateShedCounts()));
+  QObject::connect(db_, SIGNAL(databaseCleared()),
+                   this, SLOT(updateShedCounts()));
 
   QList<int> sizes;
   sizes.append(100);
@@ -245,11 +305,74 @@ void ConsoleWindow::connected(bool connected)
   }
 }
 
+void ConsoleWindow::showSourceStatus(const QString &message)
+{
+  statusBar()->showMessage(message);
+}
+
+void ConsoleWindow::updateShedCounts()
+{
+  qint64 debug_count = db_->shedDebugCount();
+  qint64 info_count = db_->shedInfoCount();
+  shed_label_->setVisible(debug_count > 0 || info_count > 0);
+  shed_label_->setText(QString("Overloaded, dropped %1 DEBUG and %2 INFO")
+                       .arg(debug_count)
+                       .arg(info_count));
+}
+
 void ConsoleWindow::closeEvent(QCloseEvent *event)
 {
   QMainWindow::closeEvent(event);
 }
 
+void ConsoleWindow::showEvent(QShowEvent *event)
+{
+  QMainWindow::showEvent(event);
+
+  // The native window doesn't exist until we are shown for the first
+  // time.  We watch it for expose events so that we also notice when
+  // the window system tells us we are completely obscured.
+  if (windowHandle()) {
+    windowHandle()->removeEventFilter(this);
+    windowHandle()->installEventFilter(this);
+  }
+  updateSuspended();
+}
+
+void ConsoleWindow::hideEvent(QHideEvent *event)
+{
+  QMainWindow::hideEvent(event);
+  updateSuspended();
+}
+
+void ConsoleWindow::changeEvent(QEvent *event)
+{
+  QMainWindow::changeEvent(event);
+  if (event->type() == QEvent::WindowStateChange) {
+    updateSuspended();
+  }
+}
+
+bool ConsoleWindow::eventFilter(QObject *obj, QEvent *event)
+{
+  if (obj == windowHandle() && event->type() == QEvent::Expose) {
+    updateSuspended();
+  }
+  return QMainWindow::eventFilter(obj, event);
+}
+
+void ConsoleWindow::updateSuspended()
+{
+  // There's no point in filtering messages that nobody can see.  The
+  // proxy model catches up in a single pass when we become visible
+  // again.
+  bool hidden = !isVisible() || isMinimized();
+  if (windowHandle() && !windowHandle()->isExposed()) {
+    hidden = true;
+  }
+  db_proxy_->setSuspended(hidden);
+}
+
 void ConsoleWindow::nodeSelectionChanged()
 {
   db_proxy_->clearSearchFailure();  // clear search failure criteria, VCM 26 April 2017
@@ -264,6 +387,7 @@ void ConsoleWindow::nodeSelectionChanged()
   }
 
   db_proxy_->setNodeFilter(nodes);
+  node_click_handler_->prefetchLoggers(std::vector<std::string>(nodes.begin(), nodes.end()));
 
   for (int i = 0; i < node_names.size(); i++) {
     node_names[i] = node_names[i].split("/", QString::SkipEmptyParts).last();
@@ -324,6 +448,9 @@ void ConsoleWindow::showLogContextMenu(const QPoint& point)
   QAction copy_extended(tr("Copy Extended"), ui.messageList);
   connect(&copy_extended, SIGNAL(triggered()), this, SLOT(copyExtendedLogs()));
 
+  QAction expand(tr("Expand/Collapse Message"), ui.messageList);
+  connect(&expand, SIGNAL(triggered()), this, SLOT(toggleCurrentMessageExpanded()));
+
   QAction alternate_row_colors(tr("Alternate Row Colors"), ui.messageList);
   alternate_row_colors.setCheckable(true);
   alternate_row_colors.setChecked(ui.messageList->alternatingRowColors());
@@ -333,17 +460,62 @@ void ConsoleWindow::showLogContextMenu(const QPoint& point)
   contextMenu.addAction(&select_all);
   contextMenu.addAction(&copy);
   contextMenu.addAction(&copy_extended);
+  contextMenu.addAction(&expand);
   contextMenu.addAction(&alternate_row_colors);
+  contextMenu.addAction(ui.action_ShowDetails);
 
   contextMenu.exec(ui.messageList->mapToGlobal(point));
 }
 
 void ConsoleWindow::userScrolled(int value)
 {
+  // The scroll bar collapses while the proxy model is being refilled
+  // after a reset, which shouldn't change what the user is following.
+  if (db_proxy_->rowCount(QModelIndex()) == 0) {
+    return;
+  }
+
   if (value != ui.messageList->verticalScrollBar()->maximum()) {
     ui.checkFollowNewest->setChecked(false);
+    db_proxy_->setViewportAnchor(ui.messageList->indexAt(QPoint(0, 0)).row());
   } else {
     ui.checkFollowNewest->setChecked(true);
+    db_proxy_->setViewportAnchor(-1);
+  }
+}
+
+void ConsoleWindow::messagesAboutToBeInserted(const QModelIndex &, int first, int)
+{
+  top_row_before_insert_ = -1;
+  if (first == 0 && !ui.checkFollowNewest->isChecked()) {
+    top_row_before_insert_ = ui.messageList->indexAt(QPoint(0, 0)).row();
+  }
+}
+
+void ConsoleWindow::messagesInserted(const QModelIndex &, int first, int last)
+{
+  // Older messages are inserted above the viewport while the proxy
+  // model is refiltering.  Shift the view down by the same number of
+  // rows so the rows the user is looking at stay put.
+  if (first != 0 || top_row_before_insert_ < 0) {
+    return;
+  }
+
+  int row = top_row_before_insert_ + (last - first + 1);
+  top_row_before_insert_ = -1;
+  ui.messageList->scrollTo(db_proxy_->index(row), QAbstractItemView::PositionAtTop);
+}
+
+void ConsoleWindow::messagesReset()
+{
+  top_row_before_insert_ = -1;
+  if (ui.checkFollowNewest->isChecked()) {
+    return;
+  }
+
+  int row = db_proxy_->anchorRow();
+  if (row >= 0) {
+    ui.messageList->scrollTo(db_proxy_->index(row), QAbstractItemView::PositionAtTop);
   }
 }
 
@@ -359,22 +531,18 @@ void ConsoleWindow::selectAllLogs()
 
 void ConsoleWindow::copyLogs()
 {
-  QStringList buffer;
-  foreach(const QModelIndex &index, ui.messageList->selectionModel()->selectedIndexes())
-  {
-    buffer << db_proxy_->data(index, Qt::DisplayRole).toString();
-  }
-  QApplication::clipboard()->setText(buffer.join(tr("\n")));
+  QApplication::clipboard()->setMimeData(
+    db_proxy_->createClipboardData(ui.messageList->selectionModel()->selection(),
+                                   LogDatabaseProxyModel::FullTextRole,
+                                   tr("\n")));
 }
 
 void ConsoleWindow::copyExtendedLogs()
 {
-  QStringList buffer;
-  foreach(const QModelIndex &index, ui.messageList->selectionModel()->selectedIndexes())
-  {
-    buffer << db_proxy_->data(index, LogDatabaseProxyModel::ExtendedLogRole).toString();
-  }
-  QApplication::clipboard()->setText(buffer.join(tr("\n\n")));
+  QApplication::clipboard()->setMimeData(
+    db_proxy_->createClipboardData(ui.messageList->selectionModel()->selection(),
+                                   LogDatabaseProxyModel::ExtendedLogRole,
+                                   tr("\n\n")));
 }
 
 void ConsoleWindow::setFollowNewest(bool follow)
@@ -383,7 +551,19 @@ void ConsoleWindow::setFollowNewest(bool follow)
   settings.setValue(SettingsKeys::FOLLOW_NEWEST, follow);
 }
 
-void ConsoleWindow::includeFilterUpdated(const QString &text)
+void ConsoleWindow::includeFilterUpdated(const QString &)
+{
+  // Restarting the timer discards the previous pending update, so
+  // only the latest text is ever applied.
+  filter_timer_.start();
+}
+
+void ConsoleWindow::excludeFilterUpdated(const QString &)
+{
+  filter_timer_.start();
+}
+
+static QStringList splitFilterText(const QString &text)
 {
   QStringList items = text.split(";", QString::SkipEmptyParts);
   QStringList filtered;
@@ -394,28 +574,79 @@ void ConsoleWindow::includeFilterUpdated(const QString &text)
       filtered.append(x);
     }
   }
+  return filtered;
+}
 
-  db_proxy_->setIncludeFilters(filtered);
-  db_proxy_->setIncludeRegexpPattern(text);
-  db_proxy_->clearSearchFailure();  // resets failed search variables, VCM 27 April 2017
-  updateIncludeLabel();
+// Removes the node/file/function filter terms (e.g. "file~planner/")
+// from a list of filter terms and returns them.
+static QStringList takeFieldTerms(QStringList *terms)
+{
+  QStringList fields;
+  QStringList others;
+  for (int i = 0; i < terms->size(); i++) {
+    if (FieldFilter::isFieldTerm((*terms)[i])) {
+      fields.append((*terms)[i]);
+    } else {
+      others.append((*terms)[i]);
+    }
+  }
+  *terms = others;
+  return fields;
 }
 
-void ConsoleWindow::excludeFilterUpdated(const QString &text)
+void ConsoleWindow::applyTextFilters()
 {
-  QStringList items = text.split(";", QString::SkipEmptyParts);
-  QStringList filtered;
-  
-  for (int i = 0; i < items.size(); i++) {
-    QString x = items[i].trimmed();
-    if (!x.isEmpty()) {
-      filtered.append(x);
+  filter_timer_.stop();
+
+  // The filters are saved as they were typed, including any field
+  // terms; only the model sees them split up.
+  QSettings settings;
+  settings.setValue(SettingsKeys::INCLUDE_FILTER, ui.includeText->text());
+  settings.setValue(SettingsKeys::EXCLUDE_FILTER, ui.excludeText->text());
+
+  // The mode toggles are applied here along with the filters they
+  // change, so that switching modes only refills the model once.
+  db_proxy_->beginFilterUpdate();
+
+  // A regular expression may contain ';' and ':' itself, so field
+  // terms are only recognized in the plain text filters.
+  const bool use_regexps = ui.action_RegularExpressions->isChecked();
+  db_proxy_->setUseRegularExpressions(use_regexps);
+  db_proxy_->setUseQueryLanguage(ui.action_QueryLanguage->isChecked());
+
+  QString include_text = ui.includeText->text();
+  QStringList include_terms = splitFilterText(include_text);
+  QStringList include_fields;
+  if (ui.action_QueryLanguage->isChecked()) {
+    // The whole include text is a query, which has its own field
+    // predicates.
+    db_proxy_->setQuery(include_text);
+  } else if (!use_regexps) {
+    include_fields = takeFieldTerms(&include_terms);
+    if (!include_fields.isEmpty()) {
+      include_text = include_terms.join(";");
+    }
+  }
+  db_proxy_->setIncludeFilters(include_terms);
+  db_proxy_->setIncludeRegexpPattern(include_text);
+
+  QString exclude_text = ui.excludeText->text();
+  QStringList exclude_terms = splitFilterText(exclude_text);
+  QStringList exclude_fields;
+  if (!use_regexps) {
+    exclude_fields = takeFieldTerms(&exclude_terms);
+    if (!exclude_fields.isEmpty()) {
+      exclude_text = exclude_terms.join(";");
     }
   }
+  db_proxy_->setExcludeFilters(exclude_terms);
+  db_proxy_->setExcludeRegexpPattern(exclude_text);
+
+  db_proxy_->setFieldFilters(include_fields, exclude_fields);
+  db_proxy_->endFilterUpdate();
 
-  db_proxy_->setExcludeFilters(filtered);
-  db_proxy_->setExcludeRegexpPattern(text);
   db_proxy_->clearSearchFailure();  // resets failed search variables, VCM 27 April 2017
+  updateIncludeLabel();
   updateExcludeLabel();
 }
 
@@ -423,6 +654,9 @@ void ConsoleWindow::excludeFilterUpdated(const QString &text)
 void ConsoleWindow::searchIndex()
 {
   updateCurrentIndex(SEARCH);
+  if (ui.pushFindAll->isChecked()) {
+    search_results_->setSearchText(ui.searchText->text());
+  }
 }
 // Slot called when 'Previous' button pushed, 13 April 2017 VCM
 void ConsoleWindow::prevIndex()
@@ -435,6 +669,30 @@ void ConsoleWindow::nextIndex()
   updateCurrentIndex(NEXT);
 }
 
+void ConsoleWindow::setFindAll(bool find_all)
+{
+  ui.searchResultsList->setVisible(find_all);
+  // The results are only maintained while they are shown.
+  search_results_->setSearchText(find_all ? ui.searchText->text() : QString());
+}
+
+void ConsoleWindow::showSearchResult(const QModelIndex &index)
+{
+  if (!index.isValid()) {
+    return;
+  }
+
+  int row = db_proxy_->rowForLogIndex(search_results_->logIndex(index.row()));
+  if (row < 0) {
+    return;
+  }
+
+  ui.checkFollowNewest->setChecked(false);
+  QModelIndex target = db_proxy_->index(row);
+  ui.messageList->setCurrentIndex(target);
+  ui.messageList->scrollTo(target, QAbstractItemView::PositionAtCenter);
+}
+
 // Search Function sF Definitions:
 //   1)search - user modified 'Search' text
 //   2)next   - user pressed 'Next' button
@@ -445,7 +703,7 @@ void ConsoleWindow::updateCurrentIndex(function sF)
   int rowSearchStart = ui.messageList->currentIndex().row();  // retrieve current index
   int increment = 1;  // used for search/next/prev; prev(ious) increment will change to -1
   QString searchText = ui.searchText->text();  // actual text to search for
-  searchText = searchText.toUpper().trimmed();  // remove lowercase and lead/trailing spaces.
+  searchText = searchText.trimmed();  // remove lead/trailing spaces.
   // next button pushed
   if(sF == NEXT){
     rowSearchStart++;  // start search row after current.
@@ -486,10 +744,13 @@ void ConsoleWindow::updateCurrentIndex(function sF)
 
 void ConsoleWindow::updateIncludeLabel()
 {
+  QString label = ui.action_QueryLanguage->isChecked() ? "Query" : "Include";
   if (db_proxy_->isIncludeValid()) {
-    ui.includeLabel->setText("Include");
+    ui.includeLabel->setText(label);
+    ui.includeLabel->setToolTip(QString());
   } else {
-    ui.includeLabel->setText("<font color='red'>Include</font>");
+    ui.includeLabel->setText("<font color='red'>" + label + "</font>");
+    ui.includeLabel->setToolTip(db_proxy_->queryError());
   }
 }
 
@@ -615,14 +876,66 @@ void ConsoleWindow::toggleAlternateRowColors(bool checked)
   settings.setValue(SettingsKeys::ALTERNATE_LOG_ROW_COLORS, checked);
 }
 
+void ConsoleWindow::toggleMessageExpanded(const QModelIndex &index)
+{
+  if (index.isValid()) {
+    db_proxy_->toggleExpanded(index.row());
+  }
+}
+
+void ConsoleWindow::toggleCurrentMessageExpanded()
+{
+  toggleMessageExpanded(ui.messageList->currentIndex());
+}
+
+void ConsoleWindow::setShowDetails(bool show)
+{
+  ui.detailsText->setVisible(show);
+
+  QSettings settings;
+  settings.setValue(SettingsKeys::SHOW_DETAILS, show);
+
+  updateDetails();
+}
+
+void ConsoleWindow::setSortNodesByRate(bool sort_by_rate)
+{
+  node_list_model_->setSortByRate(sort_by_rate);
+
+  QSettings settings;
+  settings.setValue(SettingsKeys::SORT_NODES_BY_RATE, sort_by_rate);
+}
+
+void ConsoleWindow::updateDetails()
+{
+  // The message list only shows a bounded prefix of very long lines,
+  // so the full message is only formatted here, and only when the
+  // details pane is actually visible.
+  if (!ui.detailsText->isVisible()) {
+    return;
+  }
+
+  QModelIndex index = ui.messageList->currentIndex();
+  if (!index.isValid()) {
+    ui.detailsText->clear();
+    return;
+  }
+
+  ui.detailsText->setPlainText(
+    db_proxy_->data(index, LogDatabaseProxyModel::ExtendedLogRole).toString());
+}
+
 void ConsoleWindow::loadSettings()
 {
   // First, load all the boolean settings...
   loadBooleanSetting(SettingsKeys::DISPLAY_TIMESTAMPS, ui.action_ShowTimestamps);
   loadBooleanSetting(SettingsKeys::ABSOLUTE_TIMESTAMPS, ui.action_AbsoluteTimestamps);
   loadBooleanSetting(SettingsKeys::USE_REGEXPS, ui.action_RegularExpressions);
+  loadBooleanSetting(SettingsKeys::USE_QUERY_LANGUAGE, ui.action_QueryLanguage);
   loadBooleanSetting(SettingsKeys::COLORIZE_LOGS, ui.action_ColorizeLogs);
   loadBooleanSetting(SettingsKeys::FOLLOW_NEWEST, ui.checkFollowNewest);
+  loadBooleanSetting(SettingsKeys::SHOW_DETAILS, ui.action_ShowDetails);
+  loadBooleanSetting(SettingsKeys::SORT_NODES_BY_RATE, ui.action_SortNodesByRate);
 
   // The severity level has to be handled a little differently, since they're all combined
   // into a single integer mask under the hood.  First they have to be loaded from the settings,
@@ -652,6 +965,7 @@ void ConsoleWindow::loadSettings()
   ui.includeText->setText(includeFilter);
   QString excludeFilter = settings.value(SettingsKeys::EXCLUDE_FILTER, "").toString();
   ui.excludeText->setText(excludeFilter);
+  applyTextFilters();
 
   bool alternate_row_colors = settings.value(SettingsKeys::ALTERNATE_LOG_ROW_COLORS, true).toBool();
   ui.messageList->setAlternatingRowColors(alternate_row_colors);
@@ -0,0 +1,154 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/field_filter.h>
+
+namespace swri_console
+{
+static const char *FIELD_NAMES[] = {"node", "file", "function"};
+
+// Splits a term of the form "field:text" or "field~regexp" into its
+// parts.  Returns false if the term doesn't have that form, so it
+// should be treated as plain text.  The field must be one of
+// FIELD_NAMES, spelled out right up to the separator, and the pattern
+// must follow the separator directly: "file:planner" is a field term,
+// but "file: not found" and "the profile:x" are text.
+static bool splitTerm(const QString &term,
+                      QString *field,
+                      QString *pattern,
+                      bool *use_regexp)
+{
+  int colon = term.indexOf(':');
+  int tilde = term.indexOf('~');
+  int split = colon;
+  if (split < 0 || (tilde >= 0 && tilde < split)) {
+    split = tilde;
+  }
+  if (split <= 0 || split + 1 >= term.size() || term[split + 1].isSpace()) {
+    return false;
+  }
+
+  QString name = term.left(split).toLower();
+  bool known = false;
+  for (size_t i = 0; i < sizeof(FIELD_NAMES) / sizeof(FIELD_NAMES[0]) && !known; i++) {
+    known = (name == FIELD_NAMES[i]);
+  }
+  if (!known) {
+    return false;
+  }
+
+  *field = name;
+  *pattern = term.mid(split + 1).trimmed();
+  *use_regexp = (term[split] == '~');
+  return true;
+}
+
+FieldFilter::FieldFilter(const QString &field)
+  :
+  field_(field),
+  generation_(0)
+{
+}
+
+bool FieldFilter::isFieldTerm(const QString &term)
+{
+  QString field;
+  QString pattern;
+  bool use_regexp;
+  return splitTerm(term, &field, &pattern, &use_regexp);
+}
+
+bool FieldFilter::Term::matches(const QString &value) const
+{
+  if (use_regexp) {
+    return regexp.indexIn(value) >= 0;
+  }
+  return value.contains(text, Qt::CaseInsensitive);
+}
+
+std::vector<FieldFilter::Term> FieldFilter::parseTerms(const QString &field,
+                                                       const QStringList &terms)
+{
+  std::vector<Term> parsed;
+  for (int i = 0; i < terms.size(); i++) {
+    Term term;
+    QString term_field;
+    if (!splitTerm(terms[i], &term_field, &term.text, &term.use_regexp) ||
+        term_field != field) {
+      continue;
+    }
+
+    if (term.use_regexp) {
+      term.regexp = QRegExp(term.text, Qt::CaseSensitive);
+      if (!term.regexp.isValid()) {
+        // Like the message regexp filters, an invalid pattern is
+        // ignored until the user finishes typing it.
+        continue;
+      }
+    }
+    parsed.push_back(term);
+  }
+  return parsed;
+}
+
+bool FieldFilter::setTerms(const QStringList &include_terms,
+                           const QStringList &exclude_terms)
+{
+  std::vector<Term> includes = parseTerms(field_, include_terms);
+  std::vector<Term> excludes = parseTerms(field_, exclude_terms);
+  if (includes == includes_ && excludes == excludes_) {
+    return false;
+  }
+
+  includes_ = includes;
+  excludes_ = excludes;
+  verdicts_.clear();
+  return true;
+}
+
+void FieldFilter::evaluate(const StringTable &values)
+{
+  // Evaluate every value in the table rather than just the requested
+  // one; new values tend to show up in bursts.
+  verdicts_.reserve(values.size());
+  for (size_t i = verdicts_.size(); i < values.size(); i++) {
+    QString value = QString::fromStdString(values.value(i));
+
+    bool accepted = includes_.empty();
+    for (size_t j = 0; !accepted && j < includes_.size(); j++) {
+      accepted = includes_[j].matches(value);
+    }
+    for (size_t j = 0; accepted && j < excludes_.size(); j++) {
+      accepted = !excludes_[j].matches(value);
+    }
+    verdicts_.push_back(accepted);
+  }
+}
+}  // namespace swri_console
@@ -0,0 +1,169 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <algorithm>
+
+#include <swri_console/idle_scheduler.h>
+
+#include <QElapsedTimer>
+
+namespace swri_console
+{
+// Initial estimate of the cost per item for a newly scheduled task.
+// This is intentionally pessimistic so that the first slice of an
+// expensive task doesn't overrun the budget by much.
+static const double INITIAL_NS_PER_ITEM = 10000.0;
+// Weight given to the latest measurement when updating the estimate.
+static const double COST_SMOOTHING = 0.5;
+static const size_t MIN_CHUNK_SIZE = 1;
+static const size_t MAX_CHUNK_SIZE = 1000000;
+// Time spent on idle tasks per event loop iteration.  Short enough
+// that input never waits noticeably, long enough to make progress.
+static const qint64 BUDGET_NS = 4 * 1000000;
+
+IdleScheduler::IdleScheduler()
+{
+  // A zero interval timer fires once the event loop has processed all
+  // pending events, which lets input get in between slices.
+  timer_.setSingleShot(true);
+  timer_.setInterval(0);
+  QObject::connect(&timer_, SIGNAL(timeout()),
+                   this, SLOT(runSlice()));
+}
+
+IdleScheduler::~IdleScheduler()
+{
+}
+
+void IdleScheduler::schedule(IdleTask *task)
+{
+  for (size_t i = 0; i < tasks_.size(); i++) {
+    if (tasks_[i].task == task) {
+      if (!timer_.isActive()) {
+        timer_.start();
+      }
+      return;
+    }
+  }
+
+  tasks_.push_back(TaskInfo(task, INITIAL_NS_PER_ITEM));
+  if (!timer_.isActive()) {
+    timer_.start();
+  }
+}
+
+void IdleScheduler::cancel(IdleTask *task)
+{
+  // Tasks may be cancelled while a slice is running, so we only clear
+  // the entry here and compact the list afterwards.
+  for (size_t i = 0; i < tasks_.size(); i++) {
+    if (tasks_[i].task == task) {
+      tasks_[i].task = NULL;
+    }
+  }
+}
+
+void IdleScheduler::runSlice()
+{
+  QElapsedTimer elapsed;
+  elapsed.start();
+
+  bool work_remaining = true;
+  while (work_remaining && elapsed.nsecsElapsed() < BUDGET_NS) {
+    work_remaining = false;
+
+    // Tasks are run round-robin, with each task getting an even share
+    // of the time that is left in this slice.  Note that tasks can be
+    // scheduled or cancelled from within processIdleWork, so we can't
+    // hold references into tasks_ across the call.
+    const size_t task_count = tasks_.size();
+    for (size_t i = 0; i < task_count && i < tasks_.size(); i++) {
+      IdleTask *task = tasks_[i].task;
+      if (task == NULL) {
+        continue;
+      }
+
+      if (!task->hasIdleWork()) {
+        tasks_[i].task = NULL;
+        continue;
+      }
+
+      qint64 remaining = BUDGET_NS - elapsed.nsecsElapsed();
+      if (remaining <= 0) {
+        work_remaining = true;
+        break;
+      }
+
+      double share = static_cast<double>(remaining) / (task_count - i);
+      size_t chunk = static_cast<size_t>(share / tasks_[i].ns_per_item);
+      chunk = std::min(std::max(chunk, MIN_CHUNK_SIZE), MAX_CHUNK_SIZE);
+
+      qint64 start = elapsed.nsecsElapsed();
+      size_t processed = task->processIdleWork(chunk);
+      qint64 spent = elapsed.nsecsElapsed() - start;
+
+      if (tasks_[i].task != task) {
+        // The task cancelled itself.
+        continue;
+      }
+
+      if (processed > 0) {
+        double cost = static_cast<double>(spent) / processed;
+        tasks_[i].ns_per_item = ((1.0 - COST_SMOOTHING) * tasks_[i].ns_per_item +
+                                 COST_SMOOTHING * std::max(cost, 1.0));
+      }
+
+      if (task->hasIdleWork()) {
+        work_remaining = true;
+      } else {
+        tasks_[i].task = NULL;
+      }
+    }
+
+    removeCancelledTasks();
+  }
+
+  removeCancelledTasks();
+  if (!tasks_.empty()) {
+    timer_.start();
+  }
+}
+
+void IdleScheduler::removeCancelledTasks()
+{
+  size_t j = 0;
+  for (size_t i = 0; i < tasks_.size(); i++) {
+    if (tasks_[i].task != NULL) {
+      tasks_[j++] = tasks_[i];
+    }
+  }
+  tasks_.resize(j);
+}
+}  // namespace swri_console
@@ -0,0 +1,196 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/ingest_source.h>
+
+namespace swri_console
+{
+// Large enough to make the per-signal overhead negligible, small enough
+// that a load shows up in the console while it is running.
+static const size_t BATCH_SIZE = 1000;
+// How often a producer that is waiting for the consumer checks whether
+// it has been cancelled.
+static const unsigned long CANCEL_POLL_MS = 100;
+
+// Approximate memory used by a message.
+static qint64 messageBytes(const rosgraph_msgs::Log &msg)
+{
+  return (sizeof(msg) +
+          msg.name.size() +
+          msg.msg.size() +
+          msg.file.size() +
+          msg.function.size());
+}
+
+IngestSource::IngestSource(QObject *parent)
+  :
+  QObject(parent),
+  memory_budget_(0),
+  batch_bytes_(0),
+  in_flight_bytes_(0),
+  shedding_threshold_(0),
+  overloaded_(false),
+  shed_debug_(0),
+  shed_info_(0),
+  live_(false)
+{
+}
+
+IngestSource::~IngestSource()
+{
+}
+
+void IngestSource::addMessage(const rosgraph_msgs::LogConstPtr &msg)
+{
+  addMessage(msg, NULL);
+}
+
+void IngestSource::addMessage(const rosgraph_msgs::LogConstPtr &msg, const CancelToken &token)
+{
+  addMessage(msg, &token);
+}
+
+void IngestSource::addMessage(const rosgraph_msgs::LogConstPtr &msg, const CancelToken *token)
+{
+  LogBatch batch;
+  qint64 shed_debug;
+  qint64 shed_info;
+  {
+    QMutexLocker lock(&mutex_);
+    while (memory_budget_ > 0 &&
+           in_flight_bytes_ >= memory_budget_ &&
+           !(token && token->isCancelled())) {
+      consumed_.wait(&mutex_, CANCEL_POLL_MS);
+    }
+
+    if (shouldShed(*msg)) {
+      return;
+    }
+
+    batch_.push_back(msg);
+    batch_bytes_ += messageBytes(*msg);
+    if (batch_.size() < BATCH_SIZE) {
+      return;
+    }
+    batch.swap(batch_);
+    in_flight_bytes_ += batch_bytes_;
+    batch_bytes_ = 0;
+    shed_debug = shed_debug_;
+    shed_info = shed_info_;
+    shed_debug_ = 0;
+    shed_info_ = 0;
+  }
+  emitBatch(batch, shed_debug, shed_info);
+}
+
+void IngestSource::flush()
+{
+  LogBatch batch;
+  qint64 shed_debug;
+  qint64 shed_info;
+  {
+    QMutexLocker lock(&mutex_);
+    batch.swap(batch_);
+    in_flight_bytes_ += batch_bytes_;
+    batch_bytes_ = 0;
+    shed_debug = shed_debug_;
+    shed_info = shed_info_;
+    shed_debug_ = 0;
+    shed_info_ = 0;
+  }
+  emitBatch(batch, shed_debug, shed_info);
+}
+
+// Must be called with the mutex locked.
+bool IngestSource::shouldShed(const rosgraph_msgs::Log &msg)
+{
+  if (shedding_threshold_ <= 0) {
+    return false;
+  }
+
+  if (!overloaded_ && in_flight_bytes_ >= shedding_threshold_) {
+    overloaded_ = true;
+  } else if (overloaded_ && in_flight_bytes_ < shedding_threshold_ / 2) {
+    overloaded_ = false;
+    info_counts_.clear();
+  }
+
+  if (!overloaded_ || msg.level >= rosgraph_msgs::Log::WARN) {
+    return false;
+  }
+
+  if (msg.level == rosgraph_msgs::Log::DEBUG) {
+    shed_debug_++;
+    return true;
+  }
+
+  if (in_flight_bytes_ < 2 * shedding_threshold_ &&
+      info_counts_[msg.name]++ % INFO_SAMPLE_INTERVAL == 0) {
+    return false;
+  }
+  shed_info_++;
+  return true;
+}
+
+void IngestSource::emitBatch(const LogBatch &batch, qint64 shed_debug, qint64 shed_info)
+{
+  if (shed_debug || shed_info) {
+    Q_EMIT messagesShed(shed_debug, shed_info);
+  }
+  if (!batch.empty()) {
+    Q_EMIT batchReceived(batch);
+  }
+}
+
+void IngestSource::setMemoryBudget(qint64 bytes)
+{
+  QMutexLocker lock(&mutex_);
+  memory_budget_ = bytes;
+  consumed_.wakeAll();
+}
+
+void IngestSource::setSheddingThreshold(qint64 bytes)
+{
+  QMutexLocker lock(&mutex_);
+  shedding_threshold_ = bytes;
+}
+
+void IngestSource::batchConsumed(const LogBatch &batch)
+{
+  qint64 bytes = 0;
+  for (size_t i = 0; i < batch.size(); i++) {
+    bytes += messageBytes(*batch[i]);
+  }
+
+  QMutexLocker lock(&mutex_);
+  in_flight_bytes_ -= bytes;
+  consumed_.wakeAll();
+}
+}  // namespace swri_console
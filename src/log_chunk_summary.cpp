@@ -0,0 +1,104 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/log_chunk_summary.h>
+
+#include <swri_console/log_database.h>
+
+namespace swri_console
+{
+// The Bloom filter has 2^16 bits and sets two of them per trigram.  A
+// chunk of typical log messages has a few thousand distinct trigrams,
+// which leaves most bits clear, so a search for a word that doesn't
+// occur in the chunk almost always finds a clear bit.
+static const int BLOOM_BITS_LOG2 = 16;
+static const size_t BLOOM_WORDS = (1 << BLOOM_BITS_LOG2) / 64;
+
+// Computes the two bit positions for the trigram starting at text[i].
+static void trigramBits(const QString &text, int i, uint32_t *bit1, uint32_t *bit2)
+{
+  uint64_t key = ((static_cast<uint64_t>(text[i].unicode()) << 32) |
+                  (static_cast<uint64_t>(text[i + 1].unicode()) << 16) |
+                  static_cast<uint64_t>(text[i + 2].unicode()));
+  uint64_t hash = key * 0x9E3779B97F4A7C15ULL;
+  *bit1 = static_cast<uint32_t>(hash >> (64 - BLOOM_BITS_LOG2));
+  *bit2 = static_cast<uint32_t>(hash >> (64 - 2 * BLOOM_BITS_LOG2)) & ((1 << BLOOM_BITS_LOG2) - 1);
+}
+
+LogChunkSummary::LogChunkSummary()
+  :
+  min_stamp_(ros::TIME_MAX),
+  max_stamp_(ros::TIME_MIN),
+  level_mask_(0),
+  bloom_(BLOOM_WORDS, 0)
+{
+}
+
+void LogChunkSummary::add(const LogEntry &entry)
+{
+  if (entry.stamp < min_stamp_) {
+    min_stamp_ = entry.stamp;
+  }
+  if (entry.stamp > max_stamp_) {
+    max_stamp_ = entry.stamp;
+  }
+
+  level_mask_ |= entry.level;
+
+  if (entry.node_id >= nodes_.size()) {
+    nodes_.resize(entry.node_id + 1, false);
+  }
+  nodes_[entry.node_id] = true;
+
+  QString text = entry.text.join(" ").toCaseFolded();
+  for (int i = 0; i + 2 < text.size(); i++) {
+    uint32_t bit1;
+    uint32_t bit2;
+    trigramBits(text, i, &bit1, &bit2);
+    bloom_[bit1 / 64] |= 1ULL << (bit1 % 64);
+    bloom_[bit2 / 64] |= 1ULL << (bit2 % 64);
+  }
+}
+
+bool LogChunkSummary::mayContain(const QString &text) const
+{
+  QString folded = text.toCaseFolded();
+  for (int i = 0; i + 2 < folded.size(); i++) {
+    uint32_t bit1;
+    uint32_t bit2;
+    trigramBits(folded, i, &bit1, &bit2);
+    if (!(bloom_[bit1 / 64] & (1ULL << (bit1 % 64))) ||
+        !(bloom_[bit2 / 64] & (1ULL << (bit2 % 64)))) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace swri_console
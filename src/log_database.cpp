@@ -29,13 +29,50 @@
 // *****************************************************************************
 
 #include <swri_console/log_database.h>
+#include <swri_console/task_executor.h>
+
+#include <ros/init.h>
 
 namespace swri_console
 {
-LogDatabase::LogDatabase()
+const size_t LogDatabase::CHUNK_SIZE;
+
+// How often the summaries of live sources are checked, in milliseconds.
+// This matches the limiter's summary interval.
+static const int LIVE_SUMMARY_INTERVAL_MS = 1000;
+
+// ROS time can only be read once ros::start() has run, which doesn't
+// happen until a master is found, and with simulated time it is zero
+// until the first clock message.
+static bool rosTimeAvailable()
+{
+  return ros::isStarted() && ros::Time::isValid();
+}
+
+static void incrementCount(std::vector<size_t> &counts, uint32_t id)
+{
+  if (id >= counts.size()) {
+    counts.resize(id + 1, 0);
+  }
+  counts[id]++;
+}
+
+LogDatabase::LogDatabase(TaskExecutor *executor)
   :
-  min_time_(ros::TIME_MAX)
+  executor_(executor),
+  chunk_summaries_(new std::deque<LogChunkSummary>()),
+  shed_debug_count_(0),
+  shed_info_count_(0),
+  node_rate_limit_(0.0),
+  node_burst_(0.0),
+  location_rate_limit_(0.0),
+  location_burst_(0.0),
+  min_time_(ros::TIME_MAX),
+  max_time_(ros::TIME_MIN)
 {
+  summary_timer_.setInterval(LIVE_SUMMARY_INTERVAL_MS);
+  QObject::connect(&summary_timer_, SIGNAL(timeout()),
+                   this, SLOT(flushLiveSummaries()));
 }
 
 LogDatabase::~LogDatabase()
@@ -44,42 +81,343 @@ LogDatabase::~LogDatabase()
 
 void LogDatabase::clear()
 {
-  std::map<std::string, size_t>::iterator iter;
-  msg_counts_.clear();
-  log_.clear();
+  // Swapping in empty storage is constant time.  The old entries are
+  // freed in the background, since destroying millions of them would
+  // freeze the GUI.
+  log_.clear(executor_);
+  new_msgs_.clear();
+  // Unique texts (stamps, counters, poses) would otherwise accumulate
+  // for the life of the process.
+  nodes_.clear();
+  files_.clear();
+  functions_.clear();
+  texts_.clear(executor_);
+  level_counts_.clear();
+  node_counts_.clear();
+  file_counts_.clear();
+  function_counts_.clear();
+  boost::shared_ptr<std::deque<LogChunkSummary> > old_summaries = chunk_summaries_;
+  chunk_summaries_.reset(new std::deque<LogChunkSummary>());
+  if (executor_) {
+    executor_->release(old_summaries);
+  }
+  shed_debug_count_ = 0;
+  shed_info_count_ = 0;
+  for (std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.begin();
+       it != rate_limiters_.end();
+       ++it) {
+    it->second.clear();
+  }
+  max_time_ = ros::TIME_MIN;
+  node_stats_.clear();
+  pending_nodes_.clear();
+  changed_nodes_.clear();
   Q_EMIT databaseCleared();
 }
 
-void LogDatabase::queueMessage(const rosgraph_msgs::LogConstPtr msg)
+double LogDatabase::nodeRate(uint32_t node_id) const
+{
+  if (node_id >= node_stats_.size()) {
+    return 0.0;
+  }
+  const NodeStats &stats = node_stats_[node_id];
+  return stats.rate(stats.isLive() && rosTimeAvailable() ? ros::Time::now() : max_time_);
+}
+
+size_t LogDatabase::levelCount(uint8_t level) const
+{
+  std::map<uint8_t, size_t>::const_iterator it = level_counts_.find(level);
+  return it == level_counts_.end() ? 0 : it->second;
+}
+
+void LogDatabase::addMessage(const rosgraph_msgs::LogConstPtr &msg,
+                             RateLimiter &limiter,
+                             bool live)
 {
   if (msg->header.stamp < min_time_) {
     min_time_ = msg->header.stamp;
     Q_EMIT minTimeUpdated();
   }
   
-  msg_counts_[msg->name]++;
-
   LogEntry log;
   log.stamp = msg->header.stamp;
   log.level = msg->level;
-  log.node = msg->name;
-  log.file = msg->file;
-  log.function = msg->function;
+  log.node_id = nodes_.intern(msg->name);
+  log.file_id = files_.intern(msg->file);
+  log.function_id = functions_.intern(msg->function);
   log.line = msg->line;
-  log.text = QString(msg->msg.c_str()).split('\n');
+
+  if (log.node_id >= node_stats_.size()) {
+    node_stats_.resize(log.node_id + 1);
+  }
+  node_stats_[log.node_id].setLive(live);
+
+  if (!limiter.accept(log.node_id, log.file_id, log.line, log.level, log.stamp)) {
+    return;
+  }
+
+  log.text_id = texts_.intern(msg->msg);
+  log.text = texts_.value(log.text_id);
+  log.text_version = texts_.version(log.text_id);
   log.seq = msg->header.seq;
   new_msgs_.push_back(log);
 }
 
+void LogDatabase::setNodeRateLimit(double rate, double burst)
+{
+  node_rate_limit_ = rate;
+  node_burst_ = burst;
+  for (std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.begin();
+       it != rate_limiters_.end();
+       ++it) {
+    it->second.setNodeLimit(rate, burst);
+  }
+}
+
+void LogDatabase::setLocationRateLimit(double rate, double burst)
+{
+  location_rate_limit_ = rate;
+  location_burst_ = burst;
+  for (std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.begin();
+       it != rate_limiters_.end();
+       ++it) {
+    it->second.setLocationLimit(rate, burst);
+  }
+}
+
+RateLimiter& LogDatabase::rateLimiter(IngestSource *source)
+{
+  std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.find(source);
+  if (it == rate_limiters_.end()) {
+    it = rate_limiters_.insert(std::make_pair(source, RateLimiter())).first;
+    it->second.setNodeLimit(node_rate_limit_, node_burst_);
+    it->second.setLocationLimit(location_rate_limit_, location_burst_);
+  }
+  return it->second;
+}
+
+void LogDatabase::queueSuppressionSummaries(RateLimiter &limiter, bool force)
+{
+  std::vector<RateLimiter::Suppression> summaries;
+  limiter.takeSummaries(force, &summaries);
+
+  for (size_t i = 0; i < summaries.size(); i++) {
+    const RateLimiter::Suppression &summary = summaries[i];
+    const std::string &node = nodes_.value(summary.node_id);
+
+    // Summaries are logged as the node that was limited, so they pass
+    // the same node filters as the messages they replace.
+    LogEntry log;
+    log.stamp = summary.stamp;
+    log.level = summary.level;
+    log.node_id = summary.node_id;
+    log.seq = 0;
+    std::string source;
+    if (summary.by_location) {
+      log.file_id = summary.file_id;
+      log.line = summary.line;
+      source = QString("%1:%2")
+        .arg(QString::fromStdString(files_.value(summary.file_id)))
+        .arg(summary.line).toStdString();
+    } else {
+      log.file_id = files_.intern("");
+      log.line = 0;
+      source = node;
+    }
+    log.function_id = functions_.intern("");
+
+    std::string text = tr("%1 messages suppressed from %2 (rate limit)")
+      .arg(summary.count)
+      .arg(QString::fromStdString(source)).toStdString();
+    log.text_id = texts_.intern(text);
+    log.text = texts_.value(log.text_id);
+    log.text_version = texts_.version(log.text_id);
+
+    // The summary entry itself is counted by processQueue() like any
+    // other entry, so it stands in for one of the suppressed messages.
+    if (summary.count > 1) {
+      touchNodeStats(summary.node_id).addSuppressed(summary.count - 1, summary.stamp);
+    }
+    new_msgs_.push_back(log);
+  }
+}
+
+NodeStats& LogDatabase::touchNodeStats(uint32_t node_id)
+{
+  if (node_id >= node_stats_.size()) {
+    node_stats_.resize(node_id + 1);
+  }
+  // The caller always adds to the stats, so a node without pending
+  // entries is about to be changed for the first time in this batch.
+  NodeStats &stats = node_stats_[node_id];
+  if (!stats.hasPending()) {
+    pending_nodes_.push_back(node_id);
+  }
+  return stats;
+}
+
+void LogDatabase::addSource(IngestSource *source)
+{
+  QObject::connect(source, SIGNAL(batchReceived(const swri_console::LogBatch&)),
+                   this, SLOT(queueBatch(const swri_console::LogBatch&)));
+  QObject::connect(source, SIGNAL(started(const QString&)),
+                   this, SLOT(handleSourceStarted(const QString&)));
+  QObject::connect(source, SIGNAL(progress(const QString&, int)),
+                   this, SLOT(handleSourceProgress(const QString&, int)));
+  QObject::connect(source, SIGNAL(finished(const QString&)),
+                   this, SLOT(handleSourceFinished(const QString&)));
+  QObject::connect(source, SIGNAL(error(const QString&, const QString&)),
+                   this, SLOT(handleSourceError(const QString&, const QString&)));
+  QObject::connect(source, SIGNAL(messagesShed(qint64, qint64)),
+                   this, SLOT(handleMessagesShed(qint64, qint64)));
+  QObject::connect(source, SIGNAL(destroyed(QObject*)),
+                   this, SLOT(handleSourceDestroyed(QObject*)));
+
+  if (source->isLive() && !summary_timer_.isActive()) {
+    summary_timer_.start();
+  }
+}
+
+void LogDatabase::removeSource(IngestSource *source)
+{
+  QObject::disconnect(source, 0, this, 0);
+
+  std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.find(source);
+  if (it != rate_limiters_.end()) {
+    queueSuppressionSummaries(it->second, true);
+    rate_limiters_.erase(it);
+    processQueue();
+  }
+}
+
+void LogDatabase::queueBatch(const LogBatch &batch)
+{
+  IngestSource *source = qobject_cast<IngestSource*>(sender());
+  RateLimiter &limiter = rateLimiter(source);
+  const bool live = source && source->isLive();
+  for (size_t i = 0; i < batch.size(); i++) {
+    addMessage(batch[i], limiter, live);
+  }
+  processQueue();
+
+  // Let the source's producer continue if it was waiting for us.
+  if (source) {
+    source->batchConsumed(batch);
+  }
+}
+
+void LogDatabase::handleSourceStarted(const QString &description)
+{
+  Q_EMIT sourceStatus(tr("Loading %1...").arg(description));
+}
+
+void LogDatabase::handleSourceProgress(const QString &description, int percent)
+{
+  Q_EMIT sourceStatus(tr("Loading %1... %2%").arg(description).arg(percent));
+}
+
+void LogDatabase::handleSourceFinished(const QString &description)
+{
+  // Report whatever the source's last messages left suppressed rather
+  // than waiting for more messages to arrive.  Other sources may still
+  // be running, so their summaries wait for their own intervals.
+  IngestSource *source = qobject_cast<IngestSource*>(sender());
+  queueSuppressionSummaries(rateLimiter(source), true);
+  processQueue();
+  Q_EMIT sourceStatus(tr("Finished loading %1.").arg(description));
+}
+
+void LogDatabase::handleSourceError(const QString &description, const QString &message)
+{
+  Q_EMIT sourceStatus(tr("Error loading %1: %2").arg(description).arg(message));
+}
+
+void LogDatabase::handleMessagesShed(qint64 debug_count, qint64 info_count)
+{
+  shed_debug_count_ += debug_count;
+  shed_info_count_ += info_count;
+  Q_EMIT shedCountsChanged();
+}
+
+void LogDatabase::handleSourceDestroyed(QObject *source)
+{
+  // The source is already partly destroyed, so only its address can be
+  // used.
+  std::map<IngestSource*, RateLimiter>::iterator it =
+    rate_limiters_.find(static_cast<IngestSource*>(source));
+  if (it != rate_limiters_.end()) {
+    queueSuppressionSummaries(it->second, true);
+    rate_limiters_.erase(it);
+    processQueue();
+  }
+}
+
+void LogDatabase::flushLiveSummaries()
+{
+  // A live source never finishes, and once a storm stops there are no
+  // new stamps to make its summaries due.  Stamps of live messages are
+  // ROS time, so the clock stands in for the next stamp.
+  if (!rosTimeAvailable()) {
+    return;
+  }
+  const ros::Time now = ros::Time::now();
+  for (std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.begin();
+       it != rate_limiters_.end();
+       ++it) {
+    if (it->first && it->first->isLive()) {
+      it->second.advanceTo(now);
+    }
+  }
+  processQueue();
+}
+
 void LogDatabase::processQueue()
 {
+  if (executor_) {
+    // Compressed chunks keep their own copy of each text, so the table
+    // only needs to hold the texts of the hot entries.
+    std::vector<uint32_t> released_texts;
+    log_.compressColdChunks(executor_, &released_texts);
+    for (size_t i = 0; i < released_texts.size(); i++) {
+      texts_.release(released_texts[i]);
+    }
+  }
+
+  for (std::map<IngestSource*, RateLimiter>::iterator it = rate_limiters_.begin();
+       it != rate_limiters_.end();
+       ++it) {
+    queueSuppressionSummaries(it->second, false);
+  }
   if (new_msgs_.empty()) {
     return;
   }
   
-  log_.insert(log_.end(),
-              new_msgs_.begin(),
-              new_msgs_.end());
+  for (size_t i = 0; i < new_msgs_.size(); i++) {
+    const LogEntry &entry = new_msgs_[i];
+    level_counts_[entry.level]++;
+    incrementCount(node_counts_, entry.node_id);
+    incrementCount(file_counts_, entry.file_id);
+    incrementCount(function_counts_, entry.function_id);
+
+    if ((log_.size() + i) % CHUNK_SIZE == 0) {
+      chunk_summaries_->push_back(LogChunkSummary());
+    }
+    chunk_summaries_->back().add(entry);
+    touchNodeStats(entry.node_id).add(entry);
+    if (entry.stamp > max_time_) {
+      max_time_ = entry.stamp;
+    }
+  }
+
+  // Only the nodes in this batch need their rates updated; the others
+  // decay implicitly when their rates are read.
+  for (size_t i = 0; i < pending_nodes_.size(); i++) {
+    node_stats_[pending_nodes_[i]].updateRate();
+  }
+  changed_nodes_.swap(pending_nodes_);
+  pending_nodes_.clear();
+
+  log_.append(new_msgs_);
   new_msgs_.clear();
 
   Q_EMIT messagesAdded();              
@@ -31,37 +31,97 @@
 #include <stdio.h>
 #include <algorithm>
 #include <iterator>
+#include <limits>
 
 #include <ros/time.h>
 #include <rosbag/bag.h>
 
 #include <swri_console/log_database_proxy_model.h>
 #include <swri_console/log_database.h>
+#include <swri_console/log_line_format.h>
+#include <swri_console/log_mime_data.h>
 #include <swri_console/settings_keys.h>
 
 #include <QColor>
 #include <QFile>
 #include <QTextStream>
-#include <QTimer>
 #include <QSettings>
 #include <QtGlobal>
 
 namespace swri_console
 {
-LogDatabaseProxyModel::LogDatabaseProxyModel(LogDatabase *db)
+const size_t LogDatabaseProxyModel::NO_ANCHOR = std::numeric_limits<size_t>::max();
+
+// The maximum number of characters of a message that are shown in its
+// tooltip.
+static const int MAX_TOOLTIP_LENGTH = 4096;
+
+// Returns true if every string in `strings` contains at least one of
+// the strings in `candidates` (case insensitive).  If this holds, any
+// message containing one of `strings` also contains one of
+// `candidates`.
+static bool allContainAnyOf(const QStringList &strings,
+                            const QStringList &candidates)
+{
+  for (int i = 0; i < strings.size(); i++) {
+    bool found = false;
+    for (int j = 0; !found && j < candidates.size(); j++) {
+      found = strings[i].contains(candidates[j], Qt::CaseInsensitive);
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the pattern doesn't use any regular expression
+// syntax, so that it only matches its own text.
+static bool isLiteralPattern(const QString &pattern)
+{
+  static const QString special("\\^$.|?*+()[]{}");
+  for (int i = 0; i < pattern.size(); i++) {
+    if (special.contains(pattern[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+LogDatabaseProxyModel::LogDatabaseProxyModel(LogDatabase *db,
+                                             IdleScheduler *scheduler)
   :
+  node_generation_(0),
+  text_generation_(0),
+  node_field_filter_("node"),
+  file_field_filter_("file"),
+  function_field_filter_("function"),
+  severity_mask_(0),
   colorize_logs_(true),
   display_time_(true),
   display_absolute_time_(false),
   display_logger_(false),
   display_function_(false),
   use_regular_expressions_(false),
+  use_query_language_(false),
+  suspended_(false),
+  latest_log_index_(db->log().size()),
+  filling_forward_(false),
+  hint_change_(FILTER_UNCHANGED),
+  filter_update_depth_(0),
+  pending_change_(FILTER_UNCHANGED),
+  hint_begin_(0),
+  hint_end_(0),
+  anchor_log_index_(NO_ANCHOR),
+  earliest_log_index_(db->log().size()),
+  query_(db),
   debug_color_(Qt::gray),
   info_color_(Qt::black),
   warn_color_(QColor(255,127,0)),
   error_color_(Qt::red),
   fatal_color_(Qt::magenta),
   db_(db),
+  scheduler_(scheduler),
   failedSearchText_(""),
   failedSearchIndex_(0)
 {
@@ -72,22 +132,57 @@ LogDatabaseProxyModel::LogDatabaseProxyModel(LogDatabase *db)
 
   QObject::connect(db_, SIGNAL(minTimeUpdated()),
                    this, SLOT(minTimeUpdated()));
+
+  scheduleIdleProcessing();
 }
 
 LogDatabaseProxyModel::~LogDatabaseProxyModel()
 {
+  scheduler_->cancel(this);
 }
 
 void LogDatabaseProxyModel::setNodeFilter(const std::set<std::string> &names)
 {
+  FilterChange change = FILTER_CHANGED;
+  if (names == names_) {
+    change = FILTER_UNCHANGED;
+  } else if (std::includes(names_.begin(), names_.end(),
+                           names.begin(), names.end())) {
+    change = FILTER_NARROWED;
+  } else if (std::includes(names.begin(), names.end(),
+                           names_.begin(), names_.end())) {
+    change = FILTER_WIDENED;
+  }
+
   names_ = names;
-  reset();
+  accepted_nodes_.clear();
+  applyFilterChange(change);
+}
+
+void LogDatabaseProxyModel::setFieldFilters(const QStringList &include_terms,
+                                            const QStringList &exclude_terms)
+{
+  // Use non-short-circuiting operators so that every filter is updated.
+  bool changed = node_field_filter_.setTerms(include_terms, exclude_terms);
+  changed |= file_field_filter_.setTerms(include_terms, exclude_terms);
+  changed |= function_field_filter_.setTerms(include_terms, exclude_terms);
+
+  applyFilterChange(changed ? FILTER_CHANGED : FILTER_UNCHANGED);
 }
 
 void LogDatabaseProxyModel::setSeverityFilter(uint8_t severity_mask)
 {
+  FilterChange change = FILTER_CHANGED;
+  if (severity_mask == severity_mask_) {
+    change = FILTER_UNCHANGED;
+  } else if ((severity_mask & ~severity_mask_) == 0) {
+    change = FILTER_NARROWED;
+  } else if ((severity_mask_ & ~severity_mask) == 0) {
+    change = FILTER_WIDENED;
+  }
+
   severity_mask_ = severity_mask;
-  reset();
+  applyFilterChange(change);
 }
 
 void LogDatabaseProxyModel::setAbsoluteTime(bool absolute)
@@ -177,44 +272,137 @@ void LogDatabaseProxyModel::setUseRegularExpressions(bool useRegexps)
   }
 
   use_regular_expressions_ = useRegexps;
+  text_verdicts_.clear();
   QSettings settings;
   settings.setValue(SettingsKeys::USE_REGEXPS, useRegexps);
-  reset();
+  applyFilterChange(FILTER_CHANGED);
+}
+
+void LogDatabaseProxyModel::setUseQueryLanguage(bool use_query)
+{
+  if (use_query == use_query_language_) {
+    return;
+  }
+
+  use_query_language_ = use_query;
+  text_verdicts_.clear();
+  QSettings settings;
+  settings.setValue(SettingsKeys::USE_QUERY_LANGUAGE, use_query);
+  applyFilterChange(FILTER_CHANGED);
+}
+
+void LogDatabaseProxyModel::setQuery(const QString &text)
+{
+  if (text == query_.text()) {
+    return;
+  }
+
+  query_.parse(text);
+  applyFilterChange(use_query_language_ ? FILTER_CHANGED : FILTER_UNCHANGED);
+}
+
+void LogDatabaseProxyModel::beginFilterUpdate()
+{
+  filter_update_depth_++;
+}
+
+void LogDatabaseProxyModel::endFilterUpdate()
+{
+  if (filter_update_depth_ == 0 || --filter_update_depth_ > 0) {
+    return;
+  }
+
+  FilterChange change = pending_change_;
+  pending_change_ = FILTER_UNCHANGED;
+  applyFilterChange(change);
 }
 
 void LogDatabaseProxyModel::setIncludeFilters(
   const QStringList &list)
 {
+  // An entry passes the include filter if it contains any of the
+  // strings, and an empty list accepts everything.
+  FilterChange change = FILTER_CHANGED;
+  if (use_regular_expressions_ || use_query_language_ || list == include_strings_) {
+    // The string list isn't used in regexp or query mode.
+    change = FILTER_UNCHANGED;
+  } else if (include_strings_.empty() ||
+             (!list.empty() && allContainAnyOf(list, include_strings_))) {
+    change = FILTER_NARROWED;
+  } else if (list.empty() || allContainAnyOf(include_strings_, list)) {
+    change = FILTER_WIDENED;
+  }
+
   include_strings_ = list;
-  // The text and regexp filters are always updated at the same time, so this
-  // value will be saved by setIncludeRegexpPattern.
-  reset();
+  text_verdicts_.clear();
+  applyFilterChange(change);
 }
 
 void LogDatabaseProxyModel::setExcludeFilters(
   const QStringList &list)
 {
+  // An entry is rejected by the exclude filter if it contains any of
+  // the strings, and an empty list rejects nothing.
+  FilterChange change = FILTER_CHANGED;
+  if (use_regular_expressions_ || list == exclude_strings_) {
+    change = FILTER_UNCHANGED;
+  } else if (exclude_strings_.empty() ||
+             (!list.empty() && allContainAnyOf(exclude_strings_, list))) {
+    change = FILTER_NARROWED;
+  } else if (list.empty() || allContainAnyOf(list, exclude_strings_)) {
+    change = FILTER_WIDENED;
+  }
+
   exclude_strings_ = list;
-  // The text and regexp filters are always updated at the same time, so this
-  // value will be saved by setExcludeRegexpPattern.
-  reset();
+  text_verdicts_.clear();
+  applyFilterChange(change);
 }
 
 
 void LogDatabaseProxyModel::setIncludeRegexpPattern(const QString& pattern)
 {
+  // We can only reason about the relationship between two regexps
+  // when they are both plain text.
+  QString old_pattern = include_regexp_.pattern();
+  FilterChange change = FILTER_CHANGED;
+  if (!use_regular_expressions_ || use_query_language_ || pattern == old_pattern) {
+    change = FILTER_UNCHANGED;
+  } else if (isLiteralPattern(pattern) && isLiteralPattern(old_pattern)) {
+    if (pattern.contains(old_pattern)) {
+      change = FILTER_NARROWED;
+    } else if (old_pattern.contains(pattern)) {
+      change = FILTER_WIDENED;
+    }
+  }
+
   include_regexp_.setPattern(pattern);
-  QSettings settings;
-  settings.setValue(SettingsKeys::INCLUDE_FILTER, pattern);
-  reset();
+  text_verdicts_.clear();
+  include_prefilter_.setRegExp(include_regexp_);
+  applyFilterChange(change);
 }
 
 void LogDatabaseProxyModel::setExcludeRegexpPattern(const QString& pattern)
 {
+  // An empty exclude pattern rejects nothing, so it is the widest
+  // possible filter.
+  QString old_pattern = exclude_regexp_.pattern();
+  FilterChange change = FILTER_CHANGED;
+  if (!use_regular_expressions_ || pattern == old_pattern) {
+    change = FILTER_UNCHANGED;
+  } else if (isLiteralPattern(pattern) && isLiteralPattern(old_pattern)) {
+    if (pattern.isEmpty()) {
+      change = FILTER_WIDENED;
+    } else if (old_pattern.isEmpty() || old_pattern.contains(pattern)) {
+      change = FILTER_NARROWED;
+    } else if (pattern.contains(old_pattern)) {
+      change = FILTER_WIDENED;
+    }
+  }
+
   exclude_regexp_.setPattern(pattern);
-  QSettings settings;
-  settings.setValue(SettingsKeys::EXCLUDE_FILTER, pattern);
-  reset();
+  text_verdicts_.clear();
+  exclude_prefilter_.setRegExp(exclude_regexp_);
+  applyFilterChange(change);
 }
 
 void LogDatabaseProxyModel::setDebugColor(const QColor& debug_color)
@@ -222,7 +410,11 @@ void LogDatabaseProxyModel::setDebugColor(const QColor& debug_color)
   debug_color_ = debug_color;
   QSettings settings;
   settings.setValue(SettingsKeys::DEBUG_COLOR, debug_color);
-  reset();
+
+  // Colors don't affect filtering, so there's no need to rescan.
+  if (colorize_logs_ && !msg_mapping_.empty()) {
+    Q_EMIT dataChanged(index(0), index(msg_mapping_.size()));
+  }
 }
 
 void LogDatabaseProxyModel::setInfoColor(const QColor& info_color)
@@ -230,7 +422,10 @@ void LogDatabaseProxyModel::setInfoColor(const QColor& info_color)
   info_color_ = info_color;
   QSettings settings;
   settings.setValue(SettingsKeys::INFO_COLOR, info_color);
-  reset();
+
+  if (colorize_logs_ && !msg_mapping_.empty()) {
+    Q_EMIT dataChanged(index(0), index(msg_mapping_.size()));
+  }
 }
 
 void LogDatabaseProxyModel::setWarnColor(const QColor& warn_color)
@@ -238,7 +433,10 @@ void LogDatabaseProxyModel::setWarnColor(const QColor& warn_color)
   warn_color_ = warn_color;
   QSettings settings;
   settings.setValue(SettingsKeys::WARN_COLOR, warn_color);
-  reset();
+
+  if (colorize_logs_ && !msg_mapping_.empty()) {
+    Q_EMIT dataChanged(index(0), index(msg_mapping_.size()));
+  }
 }
 
 void LogDatabaseProxyModel::setErrorColor(const QColor& error_color)
@@ -246,7 +444,10 @@ void LogDatabaseProxyModel::setErrorColor(const QColor& error_color)
   error_color_ = error_color;
   QSettings settings;
   settings.setValue(SettingsKeys::ERROR_COLOR, error_color);
-  reset();
+
+  if (colorize_logs_ && !msg_mapping_.empty()) {
+    Q_EMIT dataChanged(index(0), index(msg_mapping_.size()));
+  }
 }
 
 void LogDatabaseProxyModel::setFatalColor(const QColor& fatal_color)
@@ -254,7 +455,10 @@ void LogDatabaseProxyModel::setFatalColor(const QColor& fatal_color)
   fatal_color_ = fatal_color;
   QSettings settings;
   settings.setValue(SettingsKeys::FATAL_COLOR, fatal_color);
-  reset();
+
+  if (colorize_logs_ && !msg_mapping_.empty()) {
+    Q_EMIT dataChanged(index(0), index(msg_mapping_.size()));
+  }
 }
 
 int LogDatabaseProxyModel::rowCount(const QModelIndex &parent) const
@@ -269,6 +473,9 @@ int LogDatabaseProxyModel::rowCount(const QModelIndex &parent) const
 
 bool LogDatabaseProxyModel::isIncludeValid() const
 {
+  if (use_query_language_) {
+    return query_.isValid();
+  }
   if (use_regular_expressions_ && !include_regexp_.isValid()) {
     return false;
   }
@@ -320,13 +527,24 @@ int LogDatabaseProxyModel::getItemIndex(const QString searchText, int index, int
     index = failedSearchIndex_-1;
     counter = failedSearchIndex_;
   }
+  // Chunks whose summary shows that they can't contain the text are
+  // skipped without looking at their messages.  The summaries join
+  // lines with spaces, so they can't rule out text that contains '|'.
+  // The match is case insensitive with the same case folding the
+  // summaries use, so a chunk is never skipped when it has a match.
+  const bool useSummaries = !searchText.contains('|');
+  size_t searchChunk = std::numeric_limits<size_t>::max();
+  bool chunkMayMatch = true;
   int i;
   for(i=0; i<msg_mapping_.size();i++)  // loop through all messages until end or match is found
   {
     const LineMap line_idx = msg_mapping_[index];
+    if (useSummaries && line_idx.log_index / LogDatabase::CHUNK_SIZE != searchChunk) {
+      searchChunk = line_idx.log_index / LogDatabase::CHUNK_SIZE;
+      chunkMayMatch = db_->chunkSummary(line_idx.log_index).mayContain(searchText);
+    }
     const LogEntry &item = db_->log()[line_idx.log_index];
-    QString tempString = item.text.join("|");  // concatenate strings
-    if(tempString.toUpper().contains(searchText))  // search match found
+    if(chunkMayMatch && item.text.join("|").contains(searchText, Qt::CaseInsensitive))  // search match found
     {
       clearSearchFailure();  // reset failed search variables
       return index;  // match found, return location and exit loop
@@ -365,6 +583,17 @@ void LogDatabaseProxyModel::clearSearchFailure()
 
 QVariant LogDatabaseProxyModel::data(
   const QModelIndex &index, int role) const
+{
+  if (index.parent().isValid() ||
+      static_cast<size_t>(index.row()) >= msg_mapping_.size()) {
+    return QVariant();
+  }
+
+  return lineData(msg_mapping_[index.row()], role);
+}
+
+QVariant LogDatabaseProxyModel::lineData(
+  const LineMap &line_idx, int role) const
 {
   switch (role)
   {
@@ -373,6 +602,7 @@ QVariant LogDatabaseProxyModel::data(
     case Qt::DisplayRole:
     case Qt::ToolTipRole:
     case ExtendedLogRole:
+    case FullTextRole:
       break;
     case Qt::ForegroundRole:
       if (colorize_logs_) {
@@ -382,82 +612,20 @@ QVariant LogDatabaseProxyModel::data(
       return QVariant();
   }
 
-  if (index.parent().isValid() &&
-      static_cast<size_t>(index.row()) >= msg_mapping_.size()) {
-    return QVariant();
-  }
-
-  const LineMap line_idx = msg_mapping_[index.row()];
   const LogEntry &item = db_->log()[line_idx.log_index];
 
-  if (role == Qt::DisplayRole) {
-    char level = '?';
-    if (item.level == rosgraph_msgs::Log::DEBUG) {
-      level = 'D';
-    } else if (item.level == rosgraph_msgs::Log::INFO) {
-      level = 'I';
-    } else if (item.level == rosgraph_msgs::Log::WARN) {
-      level = 'W';
-    } else if (item.level == rosgraph_msgs::Log::ERROR) {
-      level = 'E';
-    } else if (item.level == rosgraph_msgs::Log::FATAL) {
-      level = 'F';
-    }
-
-    char stamp[128];
-    if (display_absolute_time_) {
-      snprintf(stamp, sizeof(stamp),
-               "%u.%09u",
-               item.stamp.sec,
-               item.stamp.nsec);
-    } else {
-      ros::Duration t = item.stamp - db_->minTime();
-
-      int32_t secs = t.sec;
-      int hours = secs / 60 / 60;
-      int minutes = (secs / 60) % 60;
-      int seconds = (secs % 60);
-      int milliseconds = t.nsec / 1000000;
-      
-      snprintf(stamp, sizeof(stamp),
-               "%d:%02d:%02d:%03d",
-               hours, minutes, seconds, milliseconds);
-    }
-
-    char id[256];
-    if (display_logger_ && display_function_) {
-      snprintf(id, sizeof(id), "%s::%s", item.node.c_str(), item.function.c_str());
-    } else if (display_logger_ && !display_function_) {
-      snprintf(id, sizeof(id), "%s", item.node.c_str());
-    } else if (!display_logger_ && display_function_) {
-      snprintf(id, sizeof(id), "::%s", item.function.c_str());
-    }
-
-    bool display_id = display_logger_ || display_function_;
-
-    char header[1024];
-    if (display_time_ && display_id) {
-      snprintf(header, sizeof(header), "%c %s [%s] ", level, stamp, id);
-    } else if (display_time_) {
-      snprintf(header, sizeof(header), "%c %s [] ", level, stamp);
-    } else if (display_id) {
-      snprintf(header, sizeof(header), "%c [%s] ", level, id);
-    } else {
-      snprintf(header, sizeof(header), "%c [] ", level);
-    }
-
-    // For multiline messages, we only want to display the header for
-    // the first line.  For the subsequent lines, we generate a header
-    // and then fill it with blank lines so that the messages are
-    // aligned properly (assuming monospaced font).  
-    if (line_idx.line_index != 0) {
-      size_t len = strnlen(header, sizeof(header));
-      for (size_t i = 0; i < len; i++) {
-        header[i] = ' ';
-      }
-    }
-    
-    return QVariant(QString(header) + item.text[line_idx.line_index]);
+  if (role == Qt::DisplayRole || role == FullTextRole) {
+    // A collapsed multi-line message is a single row that stands in
+    // for the whole message.
+    const bool collapsed = (item.text.size() > 1 &&
+                            expanded_entries_.count(line_idx.log_index) == 0);
+    return QVariant(formatLogLine(item,
+                                  line_idx.line_index,
+                                  collapsed,
+                                  role == FullTextRole,
+                                  lineFormat(),
+                                  db_->nodes(),
+                                  db_->functions()));
   }
   else if (role == Qt::ForegroundRole && colorize_logs_) {
     switch (item.level) {
@@ -489,52 +657,309 @@ QVariant LogDatabaseProxyModel::data(
              item.stamp.sec,
              item.stamp.nsec,
              item.seq,
-             item.node.c_str(),
-             item.function.c_str(),
-             item.file.c_str(),
+             db_->nodes().value(item.node_id).c_str(),
+             db_->functions().value(item.function_id).c_str(),
+             db_->files().value(item.file_id).c_str(),
              item.line);
     
+    QString message = item.text.join("\n");
+    if (message.size() > MAX_TOOLTIP_LENGTH) {
+      message = message.left(MAX_TOOLTIP_LENGTH) +
+        QString::fromUtf8("\xe2\x80\xa6\n[Message truncated; see the details pane for the full text.]");
+    }
+
     QString text = (QString(buffer) +
-                    item.text.join("\n") + 
+                    message +
                     QString("</p>"));
                             
     return QVariant(text);
   } else if (role == LogDatabaseProxyModel::ExtendedLogRole) {
-    char buffer[4096];
-    snprintf(buffer, sizeof(buffer),
-             "Timestamp: %d.%09d\n"
-             "Node: %s\n"
-             "Function: %s\n"
-             "File: %s\n"
-             "Line: %d\n"
-             "Message: ",
-             item.stamp.sec,
-             item.stamp.nsec,
-             item.node.c_str(),
-             item.function.c_str(),
-             item.file.c_str(),
-             item.line);
-    
-    QString text = (QString(buffer) +
-                    item.text.join("\n")); 
-                            
-    return QVariant(text);
+    return QVariant(formatExtendedLog(item,
+                                      db_->nodes(),
+                                      db_->functions(),
+                                      db_->files()));
   }
       
   return QVariant();
 }
 
+QMimeData* LogDatabaseProxyModel::createClipboardData(
+  const QItemSelection &selection,
+  int role,
+  const QString &separator)
+{
+  // Work with the selected row ranges rather than individual indexes
+  // so that selecting everything doesn't create millions of
+  // QModelIndex objects.
+  std::vector<std::pair<int, int> > ranges;
+  for (int i = 0; i < selection.size(); i++) {
+    ranges.push_back(std::make_pair(selection[i].top(), selection[i].bottom()));
+  }
+  std::sort(ranges.begin(), ranges.end());
+
+  // Drop the overlaps so that each row is copied once.
+  std::vector<std::pair<int, int> > rows;
+  int next_row = 0;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    int first = std::max(ranges[i].first, next_row);
+    int last = std::min(ranges[i].second, static_cast<int>(msg_mapping_.size()) - 1);
+    if (first > last) {
+      continue;
+    }
+    rows.push_back(std::make_pair(first, last));
+    next_row = last + 1;
+  }
+
+  // The clipboard data shares the mapping's blocks rather than copying
+  // them.  If the model changes while the clipboard still needs them,
+  // only the blocks that change are copied.
+  return new LogMimeData(db_, lineFormat(), expanded_entries_,
+                         msg_mapping_, rows, role, separator);
+}
+
+LogLineFormat LogDatabaseProxyModel::lineFormat() const
+{
+  LogLineFormat format;
+  format.display_time = display_time_;
+  format.display_absolute_time = display_absolute_time_;
+  format.display_logger = display_logger_;
+  format.display_function = display_function_;
+  format.min_time = db_->minTime();
+  return format;
+}
+
 void LogDatabaseProxyModel::reset()
 {
+  releaseHint();
+  restartFill();
+}
+
+void LogDatabaseProxyModel::restartFill(std::deque<LineMap> *previous_rows)
+{
+  if (use_query_language_) {
+    query_.refreshPlan();
+  }
+
   beginResetModel();
+  if (previous_rows) {
+    previous_rows->clear();
+    msg_mapping_.appendTo(previous_rows);
+  }
   msg_mapping_.clear();
-  early_mapping_.clear();
-  earliest_log_index_ = db_->log().size();
+  earliest_log_index_ = std::min(anchor_log_index_, db_->log().size());
   latest_log_index_ = earliest_log_index_;
+  filling_forward_ = latest_log_index_ < db_->log().size();
   endResetModel();
+  if (earliest_log_index_ == 0 && !filling_forward_) {
+    releaseHint();
+  }
+  scheduleIdleProcessing();
+}
+
+void LogDatabaseProxyModel::setSuspended(bool suspended)
+{
+  if (suspended == suspended_) {
+    return;
+  }
+
+  suspended_ = suspended;
+  if (suspended_) {
+    return;
+  }
+
+  // Catch up on everything that arrived while we were suspended.
+  // latest_log_index_ hasn't moved, so this picks up exactly where we
+  // left off.
+  processNewMessages();
   scheduleIdleProcessing();
+  minTimeUpdated();
 }
 
+void LogDatabaseProxyModel::toggleExpanded(int row)
+{
+  if (row < 0 || static_cast<size_t>(row) >= msg_mapping_.size()) {
+    return;
+  }
+
+  const LineMap line_map = msg_mapping_[row];
+  const LogEntry &item = db_->log()[line_map.log_index];
+  if (item.text.size() < 2) {
+    return;
+  }
+
+  // The first row of the entry is the only one that exists when it is
+  // collapsed.
+  const int first = row - line_map.line_index;
+  const int last = first + item.text.size() - 1;
+
+  if (expanded_entries_.erase(line_map.log_index)) {
+    beginRemoveRows(QModelIndex(), first + 1, last);
+    msg_mapping_.erase(first + 1, last + 1);
+    endRemoveRows();
+  } else {
+    expanded_entries_.insert(line_map.log_index);
+
+    std::deque<LineMap> lines;
+    for (int i = 1; i < item.text.size(); i++) {
+      lines.push_back(LineMap(line_map.log_index, i));
+    }
+
+    beginInsertRows(QModelIndex(), first + 1, last);
+    msg_mapping_.insert(first + 1, lines.begin(), lines.end());
+    endInsertRows();
+  }
+
+  Q_EMIT dataChanged(index(first), index(first));
+}
+
+int LogDatabaseProxyModel::visibleLineCount(size_t log_index, const LogEntry &item) const
+{
+  if (item.text.size() > 1 && expanded_entries_.count(log_index)) {
+    return item.text.size();
+  }
+  return 1;
+}
+
+void LogDatabaseProxyModel::setViewportAnchor(int row)
+{
+  if (row < 0 || static_cast<size_t>(row) >= msg_mapping_.size()) {
+    anchor_log_index_ = NO_ANCHOR;
+  } else {
+    anchor_log_index_ = msg_mapping_[row].log_index;
+  }
+}
+
+int LogDatabaseProxyModel::anchorRow() const
+{
+  if (anchor_log_index_ == NO_ANCHOR) {
+    return -1;
+  }
+
+  size_t row = msg_mapping_.lowerBound(LineMap(anchor_log_index_, 0));
+  if (row == msg_mapping_.size()) {
+    return -1;
+  }
+  return row;
+}
+
+int LogDatabaseProxyModel::rowForLogIndex(size_t log_index) const
+{
+  size_t row = msg_mapping_.lowerBound(LineMap(log_index, 0));
+  if (row == msg_mapping_.size() || msg_mapping_[row].log_index != log_index) {
+    return -1;
+  }
+  return row;
+}
+
+void LogDatabaseProxyModel::applyFilterChange(FilterChange change)
+{
+  if (filter_update_depth_ > 0) {
+    // Changes in the same direction still only narrow (or widen) the
+    // filter; any other combination has to be treated as a new filter.
+    if (pending_change_ == FILTER_UNCHANGED) {
+      pending_change_ = change;
+    } else if (change != FILTER_UNCHANGED && change != pending_change_) {
+      pending_change_ = FILTER_CHANGED;
+    }
+    return;
+  }
+
+  if (change == FILTER_UNCHANGED) {
+    return;
+  } else if (change == FILTER_CHANGED) {
+    reset();
+    return;
+  }
+
+  // The rows we are showing are the entries that the previous filters
+  // accepted over [earliest_log_index_, latest_log_index_).  If a
+  // refill for an earlier change in the same direction is still
+  // running, its hint still describes the entries it hasn't reached,
+  // so the two are combined.  Hints for opposite directions (or that
+  // don't cover a contiguous range) can't be combined, so we fall back
+  // to testing everything.
+  //
+  // The refill runs as idle work from the viewport anchor outward, the
+  // same as a reset, so a large log is refiltered within the
+  // scheduler's time budget and a newer change simply restarts it.
+  if (hint_change_ == FILTER_UNCHANGED) {
+    hint_change_ = change;
+    hint_begin_ = earliest_log_index_;
+    hint_end_ = latest_log_index_;
+    restartFill(&hint_mapping_);
+  } else if (hint_change_ != change ||
+             hint_end_ < earliest_log_index_ ||
+             latest_log_index_ < hint_begin_) {
+    reset();
+  } else {
+    std::deque<LineMap>::const_iterator first = std::lower_bound(
+      hint_mapping_.begin(), hint_mapping_.end(), LineMap(earliest_log_index_, 0));
+    std::deque<LineMap>::const_iterator last = std::lower_bound(
+      hint_mapping_.begin(), hint_mapping_.end(), LineMap(latest_log_index_, 0));
+    std::deque<LineMap> hint(hint_mapping_.begin(), first);
+    msg_mapping_.appendTo(&hint);
+    hint.insert(hint.end(), last, hint_mapping_.end());
+    hint_mapping_.swap(hint);
+    hint_begin_ = std::min(hint_begin_, earliest_log_index_);
+    hint_end_ = std::max(hint_end_, latest_log_index_);
+    restartFill();
+  }
+}
+
+void LogDatabaseProxyModel::releaseHint()
+{
+  hint_change_ = FILTER_UNCHANGED;
+  std::deque<LineMap>().swap(hint_mapping_);
+  hint_begin_ = 0;
+  hint_end_ = 0;
+}
+
+int LogDatabaseProxyModel::filteredLineCount(size_t log_index)
+{
+  if (hintCovers(log_index)) {
+    std::deque<LineMap>::const_iterator iter = std::lower_bound(
+      hint_mapping_.begin(), hint_mapping_.end(), LineMap(log_index, 0));
+    const bool in_hint = iter != hint_mapping_.end() && iter->log_index == log_index;
+    if (hint_change_ == FILTER_NARROWED && !in_hint) {
+      return 0;
+    } else if (hint_change_ == FILTER_WIDENED && in_hint) {
+      // The hint already has a row for each visible line.
+      int count = 0;
+      for (; iter != hint_mapping_.end() && iter->log_index == log_index; ++iter) {
+        count++;
+      }
+      return count;
+    }
+  }
+
+  const LogEntry &item = db_->log()[log_index];
+  if (!acceptLogEntry(item)) {
+    return 0;
+  }
+  return visibleLineCount(log_index, item);
+}
+
+size_t LogDatabaseProxyModel::nextHintIndex(size_t log_index) const
+{
+  std::deque<LineMap>::const_iterator iter = std::lower_bound(
+    hint_mapping_.begin(), hint_mapping_.end(), LineMap(log_index, 0));
+  if (iter == hint_mapping_.end()) {
+    return hint_end_;
+  }
+  return iter->log_index;
+}
+
+bool LogDatabaseProxyModel::previousHintIndex(size_t log_index, size_t *previous) const
+{
+  std::deque<LineMap>::const_iterator iter = std::lower_bound(
+    hint_mapping_.begin(), hint_mapping_.end(), LineMap(log_index + 1, 0));
+  if (iter == hint_mapping_.begin()) {
+    return false;
+  }
+  --iter;
+  *previous = iter->log_index;
+  return true;
+}
 
 void LogDatabaseProxyModel::saveToFile(const QString& filename) const
 {
@@ -556,8 +981,8 @@ void LogDatabaseProxyModel::saveBagFile(const QString& filename) const
     const LogEntry &item = db_->log()[line_map.log_index];
     
     rosgraph_msgs::Log log;
-    log.file = item.file;
-    log.function = item.function;
+    log.file = db_->files().value(item.file_id);
+    log.function = db_->functions().value(item.function_id);
     log.header.seq = item.seq;
     if (item.stamp < ros::TIME_MIN) {
       // Note: I think TIME_MIN is the minimum representation of
@@ -573,7 +998,7 @@ void LogDatabaseProxyModel::saveBagFile(const QString& filename) const
     log.level = item.level;
     log.line = item.line;
     log.msg = item.text.join("\n").toStdString();
-    log.name = item.node;
+    log.name = db_->nodes().value(item.node_id);
     bag.write("/rosout", log.header.stamp, log);
 
     // Advance to the next line with a different log index.
@@ -592,7 +1017,7 @@ void LogDatabaseProxyModel::saveTextFile(const QString& filename) const
   QTextStream outstream(&outFile);
   for(size_t i = 0; i < msg_mapping_.size(); i++)
   {
-    QString line = data(index(i), Qt::DisplayRole).toString();
+    QString line = data(index(i), FullTextRole).toString();
     outstream << line << '\n';
   }
   outstream.flush();
@@ -601,26 +1026,59 @@ void LogDatabaseProxyModel::saveTextFile(const QString& filename) const
 
 void LogDatabaseProxyModel::handleDatabaseCleared()
 {
+  anchor_log_index_ = NO_ANCHOR;
+  expanded_entries_.clear();
   reset();
   clearSearchFailure();  // reset failed search variables, VCM 26 April 2017
 }
 
 void LogDatabaseProxyModel::processNewMessages()
+{
+  // While we are still filling in entries after the viewport anchor,
+  // the idle processing will get to the new messages on its own.
+  if (suspended_ || filling_forward_) {
+    return;
+  }
+
+  if (use_query_language_) {
+    query_.refreshPlan();
+  }
+  appendMessages(db_->log().size());
+}
+
+void LogDatabaseProxyModel::appendMessages(size_t end_index)
 {
   std::deque<LineMap> new_items;
  
-  // Process all messages from latest_log_index_ to the end of the
-  // log.
+  // Process all messages from latest_log_index_ to end_index,
+  // skipping the chunks that can't contain a match.
+  bool check_chunk = true;
   for (;
-       latest_log_index_ < db_->log().size();
+       latest_log_index_ < end_index;
        latest_log_index_++)
   {
-    const LogEntry &item = db_->log()[latest_log_index_];    
-    if (!acceptLogEntry(item)) {
-      continue;
-    }    
+    if (check_chunk || latest_log_index_ % LogDatabase::CHUNK_SIZE == 0) {
+      check_chunk = false;
+      if (!chunkMayMatch(latest_log_index_)) {
+        size_t chunk_end = (latest_log_index_ / LogDatabase::CHUNK_SIZE + 1) * LogDatabase::CHUNK_SIZE;
+        latest_log_index_ = std::min(chunk_end, end_index) - 1;
+        continue;
+      }
+    }
 
-    for (int i = 0; i < item.text.size(); i++) {
+    // After a narrowing change, jump straight to the next entry that
+    // the previous filters accepted.
+    if (hint_change_ == FILTER_NARROWED && hintCovers(latest_log_index_)) {
+      size_t next = nextHintIndex(latest_log_index_);
+      if (next != latest_log_index_) {
+        latest_log_index_ = std::min(next, end_index) - 1;
+        check_chunk = true;
+        continue;
+      }
+    }
+
+    const int line_count = filteredLineCount(latest_log_index_);
+    for (int i = 0; i < line_count; i++) {
       new_items.push_back(LineMap(latest_log_index_, i));
     }
   }
@@ -629,64 +1087,115 @@ void LogDatabaseProxyModel::processNewMessages()
     beginInsertRows(QModelIndex(),
                     msg_mapping_.size(),
                     msg_mapping_.size() + new_items.size() - 1);
-    msg_mapping_.insert(msg_mapping_.end(),
-                        new_items.begin(),
-                        new_items.end());
+    msg_mapping_.append(new_items.begin(), new_items.end());
     endInsertRows();
 
     Q_EMIT messagesAdded();
   }  
 }
 
-void LogDatabaseProxyModel::processOldMessages()
+size_t LogDatabaseProxyModel::processIdleWork(size_t max_items)
 {
-  // We process old messages in two steps.  First, we process the
-  // remaining messages in chunks and store them in the early_mapping_
-  // buffer if they pass all the filters.  When the early mapping
-  // buffer is large enough (or we have processed everything), then we
-  // merge the early_mapping buffer in the main buffer.  This approach
-  // allows us to process very large logs without causing major lag
-  // for the user.
-  
-  for (size_t i = 0;
-       earliest_log_index_ != 0 && i < 100;
-       earliest_log_index_--, i++)
+  // After a reset, we start at the viewport anchor and work outward
+  // in both directions so that the rows the user is looking at are
+  // shown first.  Newer messages are appended directly to the end of
+  // the mapping, which doesn't disturb the view.  When we are working
+  // in both directions, the items are split evenly between them.
+  size_t forward_items = 0;
+  if (filling_forward_) {
+    forward_items = earliest_log_index_ > 0 ? (max_items + 1) / 2 : max_items;
+    size_t start_index = latest_log_index_;
+    appendMessages(std::min(latest_log_index_ + forward_items, db_->log().size()));
+    filling_forward_ = latest_log_index_ < db_->log().size();
+    forward_items = latest_log_index_ - start_index;
+  }
+
+  // Older messages are processed backwards and stored in the
+  // early_mapping buffer if they pass all the filters.  The buffer is
+  // merged into the main mapping at the end of each chunk.  The
+  // scheduler sizes the chunks to fit its time budget, so this
+  // approach allows us to process very large logs without causing
+  // major lag for the user.
+  std::deque<LineMap> early_mapping;
+  size_t backward_items = 0;
+  bool check_chunk = true;
+  for (;
+       earliest_log_index_ != 0 && forward_items + backward_items < max_items;
+       earliest_log_index_--, backward_items++)
   {
-    const LogEntry &item = db_->log()[earliest_log_index_-1];
-    if (!acceptLogEntry(item)) {
-      continue;
+    // Skipping a chunk is about as cheap as testing one entry, so it
+    // only counts as a single item.
+    if (check_chunk || earliest_log_index_ % LogDatabase::CHUNK_SIZE == 0) {
+      check_chunk = false;
+      if (!chunkMayMatch(earliest_log_index_ - 1)) {
+        size_t chunk_start = (earliest_log_index_ - 1) / LogDatabase::CHUNK_SIZE * LogDatabase::CHUNK_SIZE;
+        earliest_log_index_ = chunk_start + 1;
+        continue;
+      }
+    }
+
+    if (hint_change_ == FILTER_NARROWED && hintCovers(earliest_log_index_ - 1)) {
+      // Find the next entry worth testing, as the value of
+      // earliest_log_index_ that has it as the next entry: the previous
+      // hint entry, or the entry before the hint.
+      size_t previous;
+      size_t next;
+      if (previousHintIndex(earliest_log_index_ - 1, &previous)) {
+        next = previous + 1;
+      } else if (hint_begin_ > 0) {
+        next = hint_begin_;
+      } else {
+        // The hint starts at the beginning of the log and has nothing
+        // earlier, so nothing is left to scan.
+        earliest_log_index_ = 0;
+        break;
+      }
+      if (next != earliest_log_index_) {
+        // Undone by the loop decrement.
+        earliest_log_index_ = next + 1;
+        check_chunk = true;
+        continue;
+      }
     }
 
-    for (int i = 0; i < item.text.size(); i++) {
+    const int line_count = filteredLineCount(earliest_log_index_-1);
+    for (int i = 0; i < line_count; i++) {
       // Note that we have to add the lines backwards to maintain the proper order.
-      early_mapping_.push_front(
-        LineMap(earliest_log_index_-1, item.text.size()-1-i));
+      early_mapping.push_front(
+        LineMap(earliest_log_index_-1, line_count-1-i));
     }
   }
  
-  if ((earliest_log_index_ == 0 && early_mapping_.size()) ||
-      (early_mapping_.size() > 200)) {
+  if (!early_mapping.empty()) {
     beginInsertRows(QModelIndex(),
                     0,
-                    early_mapping_.size() - 1);
-    msg_mapping_.insert(msg_mapping_.begin(),
-                        early_mapping_.begin(),
-                        early_mapping_.end());
-    early_mapping_.clear();
+                    early_mapping.size() - 1);
+    msg_mapping_.prepend(early_mapping.begin(), early_mapping.end());
+    early_mapping.clear();
     endInsertRows();
 
     Q_EMIT messagesAdded();
   }
 
-  scheduleIdleProcessing();
+  if (!filling_forward_ && earliest_log_index_ == 0) {
+    releaseHint();
+  }
+
+  return forward_items + backward_items;
+}
+
+bool LogDatabaseProxyModel::hasIdleWork() const
+{
+  return !suspended_ && (earliest_log_index_ > 0 || filling_forward_);
 }
 
 void LogDatabaseProxyModel::scheduleIdleProcessing()
 {
-  // If we have older logs that still need to be processed, schedule a
-  // callback at the next idle time.
-  if (earliest_log_index_ > 0) {
-    QTimer::singleShot(0, this, SLOT(processOldMessages()));
+  // If we have older logs that still need to be processed, ask the
+  // scheduler to call us back when the event loop is idle.  A scan
+  // that is already scheduled will pick up the current filter state.
+  if (hasIdleWork()) {
+    scheduler_->schedule(this);
   }
 }
 
@@ -696,46 +1205,119 @@ bool LogDatabaseProxyModel::acceptLogEntry(const LogEntry &item)
     return false;
   }
   
-  if (names_.count(item.node) == 0) {
+  // The node and field filters are decided once per distinct value, so
+  // each of these checks is a table lookup regardless of the filters.
+  if (!acceptNode(item.node_id) ||
+      !node_field_filter_.accepts(db_->nodes(), item.node_id) ||
+      !file_field_filter_.accepts(db_->files(), item.file_id) ||
+      !function_field_filter_.accepts(db_->functions(), item.function_id)) {
     return false;
   }
 
-  if (!testIncludeFilter(item)) {
+  if (use_query_language_ && !query_.accepts(item)) {
     return false;
   }
 
-  if (use_regular_expressions_) {
+  return acceptText(item);
+}
+
+// The include and exclude filters only look at the message text, so
+// they are evaluated once per distinct text.
+bool LogDatabaseProxyModel::acceptText(const LogEntry &item)
+{
+  if (db_->texts().generation() != text_generation_) {
+    text_verdicts_.clear();
+    text_generation_ = db_->texts().generation();
+  }
+  if (item.text_id >= text_verdicts_.size()) {
+    text_verdicts_.resize(item.text_id + 1);
+  }
+
+  CachedTextVerdict &cached = text_verdicts_[item.text_id];
+  if (cached.verdict == TEXT_UNKNOWN || cached.version != item.text_version) {
     // For multi-line messages, we join the lines together with a
     // space to make it easy for users to use filters that spread
     // across the new lines.
-    
-    // Don't let an empty regexp filter out everything
-    return exclude_regexp_.isEmpty() || exclude_regexp_.indexIn(item.text.join(" ")) < 0;
-  } else {
-    for (int i = 0; i < exclude_strings_.size(); i++) {
-      if (item.text.join(" ").contains(exclude_strings_[i], Qt::CaseInsensitive)) {
+    QString joined = item.text.join(" ");
+    bool accept = testIncludeFilter(joined) && testExcludeFilter(joined);
+    cached.verdict = accept ? TEXT_ACCEPTED : TEXT_REJECTED;
+    cached.version = item.text_version;
+  }
+  return cached.verdict == TEXT_ACCEPTED;
+}
+
+bool LogDatabaseProxyModel::chunkMayMatch(size_t log_index)
+{
+  const LogChunkSummary &summary = db_->chunkSummary(log_index);
+  if (!summary.hasLevel(severity_mask_)) {
+    return false;
+  }
+
+  const std::vector<bool> &nodes = summary.nodes();
+  bool has_node = false;
+  for (uint32_t id = 0; id < nodes.size() && !has_node; id++) {
+    has_node = (nodes[id] &&
+                acceptNode(id) &&
+                node_field_filter_.accepts(db_->nodes(), id));
+  }
+  if (!has_node) {
+    return false;
+  }
+
+  if (use_query_language_) {
+    return query_.mayMatch(summary);
+  } else if (use_regular_expressions_) {
+    // Every match must contain all of the regexp's literals.
+    QStringList literals = include_prefilter_.literals();
+    for (int i = 0; i < literals.size(); i++) {
+      if (!summary.mayContain(literals[i])) {
         return false;
       }
     }
+  } else if (!include_strings_.empty()) {
+    for (int i = 0; i < include_strings_.size(); i++) {
+      if (summary.mayContain(include_strings_[i])) {
+        return true;
+      }
+    }
+    return false;
   }
-  
+
   return true;
 }
 
-// Return true if the item message contains at least one of the
+bool LogDatabaseProxyModel::acceptNode(uint32_t node_id)
+{
+  const StringTable &nodes = db_->nodes();
+  if (nodes.generation() != node_generation_) {
+    accepted_nodes_.clear();
+    node_generation_ = nodes.generation();
+  }
+  while (accepted_nodes_.size() <= node_id) {
+    accepted_nodes_.push_back(names_.count(nodes.value(accepted_nodes_.size())) != 0);
+  }
+  return accepted_nodes_[node_id];
+}
+
+// Return true if the message text contains at least one of the
 // strings in include_filter_.  Always returns true if there are no
-// include strings.
-bool LogDatabaseProxyModel::testIncludeFilter(const LogEntry &item)
+// include strings.  In query mode, the query takes the place of the
+// include filter.
+bool LogDatabaseProxyModel::testIncludeFilter(const QString &text)
 {
+  if (use_query_language_) {
+    return true;
+  }
+
   if (use_regular_expressions_) {
-    return include_regexp_.indexIn(item.text.join(" ")) >= 0;
+    return include_prefilter_.mayMatch(text) && include_regexp_.indexIn(text) >= 0;
   } else {
     if (include_strings_.empty()) {
       return true;
     }
 
     for (int i = 0; i < include_strings_.size(); i++) {
-      if (item.text.join(" ").contains(include_strings_[i], Qt::CaseInsensitive)) {
+      if (text.contains(include_strings_[i], Qt::CaseInsensitive)) {
         return true;
       }
     }
@@ -744,9 +1326,30 @@ bool LogDatabaseProxyModel::testIncludeFilter(const LogEntry &item)
   return false;
 }
 
+// Return false if the message text is rejected by the exclude filter.
+bool LogDatabaseProxyModel::testExcludeFilter(const QString &text)
+{
+  if (use_regular_expressions_) {
+    // Don't let an empty regexp filter out everything
+    if (exclude_regexp_.isEmpty()) {
+      return true;
+    }
+    return !exclude_prefilter_.mayMatch(text) || exclude_regexp_.indexIn(text) < 0;
+  } else {
+    for (int i = 0; i < exclude_strings_.size(); i++) {
+      if (text.contains(exclude_strings_[i], Qt::CaseInsensitive)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 void LogDatabaseProxyModel::minTimeUpdated()
 {
-  if (display_time_ &&
+  if (!suspended_ &&
+      display_time_ &&
       !display_absolute_time_
       && msg_mapping_.size()) {
     Q_EMIT dataChanged(index(0), index(msg_mapping_.size()));
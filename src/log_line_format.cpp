@@ -0,0 +1,182 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+
+#include <swri_console/log_line_format.h>
+#include <swri_console/log_database.h>
+#include <swri_console/string_table.h>
+
+namespace swri_console
+{
+// The maximum number of characters of a single line that are passed to
+// the view.
+static const int MAX_DISPLAY_LENGTH = 1024;
+
+LogLineFormat::LogLineFormat()
+  :
+  display_time(true),
+  display_absolute_time(false),
+  display_logger(true),
+  display_function(true)
+{
+}
+
+QString formatLogLine(const LogEntry &entry,
+                      int line_index,
+                      bool collapsed,
+                      bool full_text,
+                      const LogLineFormat &format,
+                      const StringTable &nodes,
+                      const StringTable &functions)
+{
+  char level = '?';
+  if (entry.level == rosgraph_msgs::Log::DEBUG) {
+    level = 'D';
+  } else if (entry.level == rosgraph_msgs::Log::INFO) {
+    level = 'I';
+  } else if (entry.level == rosgraph_msgs::Log::WARN) {
+    level = 'W';
+  } else if (entry.level == rosgraph_msgs::Log::ERROR) {
+    level = 'E';
+  } else if (entry.level == rosgraph_msgs::Log::FATAL) {
+    level = 'F';
+  }
+
+  char stamp[128];
+  if (format.display_absolute_time) {
+    snprintf(stamp, sizeof(stamp),
+             "%u.%09u",
+             entry.stamp.sec,
+             entry.stamp.nsec);
+  } else {
+    ros::Duration t = entry.stamp - format.min_time;
+
+    int32_t secs = t.sec;
+    int hours = secs / 60 / 60;
+    int minutes = (secs / 60) % 60;
+    int seconds = (secs % 60);
+    int milliseconds = t.nsec / 1000000;
+
+    snprintf(stamp, sizeof(stamp),
+             "%d:%02d:%02d:%03d",
+             hours, minutes, seconds, milliseconds);
+  }
+
+  const std::string &node = nodes.value(entry.node_id);
+  const std::string &function = functions.value(entry.function_id);
+  char id[256];
+  if (format.display_logger && format.display_function) {
+    snprintf(id, sizeof(id), "%s::%s", node.c_str(), function.c_str());
+  } else if (format.display_logger && !format.display_function) {
+    snprintf(id, sizeof(id), "%s", node.c_str());
+  } else if (!format.display_logger && format.display_function) {
+    snprintf(id, sizeof(id), "::%s", function.c_str());
+  }
+
+  bool display_id = format.display_logger || format.display_function;
+
+  char header[1024];
+  if (format.display_time && display_id) {
+    snprintf(header, sizeof(header), "%c %s [%s] ", level, stamp, id);
+  } else if (format.display_time) {
+    snprintf(header, sizeof(header), "%c %s [] ", level, stamp);
+  } else if (display_id) {
+    snprintf(header, sizeof(header), "%c [%s] ", level, id);
+  } else {
+    snprintf(header, sizeof(header), "%c [] ", level);
+  }
+
+  // For multiline messages, we only want to display the header for
+  // the first line.  For the subsequent lines, we generate a header
+  // and then fill it with blank lines so that the messages are
+  // aligned properly (assuming monospaced font).
+  if (line_index != 0) {
+    size_t len = strnlen(header, sizeof(header));
+    for (size_t i = 0; i < len; i++) {
+      header[i] = ' ';
+    }
+  }
+
+  if (full_text && collapsed) {
+    QString text = QString(header) + entry.text[0];
+    size_t len = strnlen(header, sizeof(header));
+    QString indent(static_cast<int>(len), ' ');
+    for (int i = 1; i < entry.text.size(); i++) {
+      text += "\n" + indent + entry.text[i];
+    }
+    return text;
+  }
+
+  QString badge;
+  if (collapsed) {
+    badge = QString(" [+%1 lines]").arg(entry.text.size() - 1);
+  }
+
+  // Nodes occasionally log huge blobs of data on a single line.
+  // Laying out and painting all of that text makes scrolling very
+  // slow, so the view only gets a bounded prefix.  The full text is
+  // available through the details pane.
+  const QString &line = entry.text[line_index];
+  if (!full_text && line.size() > MAX_DISPLAY_LENGTH) {
+    return (QString(header) +
+            line.left(MAX_DISPLAY_LENGTH) +
+            QString::fromUtf8(" \xe2\x80\xa6 [%1 more characters]")
+            .arg(line.size() - MAX_DISPLAY_LENGTH) +
+            badge);
+  }
+
+  return QString(header) + line + badge;
+}
+
+QString formatExtendedLog(const LogEntry &entry,
+                          const StringTable &nodes,
+                          const StringTable &functions,
+                          const StringTable &files)
+{
+  char buffer[4096];
+  snprintf(buffer, sizeof(buffer),
+           "Timestamp: %d.%09d\n"
+           "Node: %s\n"
+           "Function: %s\n"
+           "File: %s\n"
+           "Line: %d\n"
+           "Message: ",
+           entry.stamp.sec,
+           entry.stamp.nsec,
+           nodes.value(entry.node_id).c_str(),
+           functions.value(entry.function_id).c_str(),
+           files.value(entry.file_id).c_str(),
+           entry.line);
+
+  return QString(buffer) + entry.text.join("\n");
+}
+}  // namespace swri_console
@@ -0,0 +1,336 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/log_mime_data.h>
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QRunnable>
+#include <QWaitCondition>
+
+#include <swri_console/log_database.h>
+#include <swri_console/log_store.h>
+#include <swri_console/string_table.h>
+
+namespace swri_console
+{
+static const QString TEXT_MIME_TYPE("text/plain");
+
+// How many lines each thread formats at a time.  The threads check for
+// cancellation between slices.
+static const size_t SLICE_SIZE = 4096;
+
+// When the database is cleared, a copy of up to this many lines that
+// hasn't been pasted yet is formatted right away, so that it can still
+// be pasted.  Larger copies are dropped instead, so that they don't keep
+// the cleared log alive.
+static const size_t KEEP_LINES_ON_CLEAR = 10000;
+
+// Everything needed to format the copied lines, captured on the GUI
+// thread when they are copied.  Nothing is formatted until the text is
+// first requested.  Then the lines are split into slices that the GUI
+// thread and any idle workers claim one at a time, and whichever thread
+// finishes the last slice joins the results and releases the captured
+// state.  A job that is dropped instead has no text.
+struct LogMimeData::Job
+{
+  LogSnapshot log;
+  StringTable nodes;
+  StringTable functions;
+  StringTable files;
+  LogLineFormat format;
+  std::set<size_t> expanded_entries;
+  ChunkedList<LogDatabaseProxyModel::LineMap> rows;
+  std::vector<std::pair<int, int> > ranges;
+  // The number of selected rows before each range, and in total.
+  std::vector<size_t> range_offsets;
+  size_t line_count;
+  int role;
+  QString separator;
+
+  // Guards everything below, and the log snapshot, which each thread
+  // copies (under the lock) so that it has its own chunk cache.
+  QMutex mutex;
+  QWaitCondition finished;
+  bool started;
+  bool done;
+  bool dropped;
+  size_t next_slice;
+  size_t running;
+  std::vector<QString> slices;
+  QString text;
+
+  Job() : line_count(0), role(0), started(false), done(false), dropped(false), next_slice(0), running(0) {}
+
+  size_t sliceCount() const
+  {
+    return (line_count + SLICE_SIZE - 1) / SLICE_SIZE;
+  }
+
+  // Splits the lines into slices, if that hasn't been done yet.  Must be
+  // called with the mutex locked.
+  void start()
+  {
+    if (started) {
+      return;
+    }
+    started = true;
+    slices.resize(sliceCount());
+    if (slices.empty()) {
+      finish();
+    }
+  }
+
+  // Joins the formatted slices and releases everything that was only
+  // needed to format them.  Must be called with the mutex locked.
+  void finish()
+  {
+    QStringList joined;
+    for (size_t i = 0; i < slices.size(); i++) {
+      joined << slices[i];
+    }
+    std::vector<QString>().swap(slices);
+    text = joined.join(separator);
+    release();
+    finished.wakeAll();
+  }
+
+  // Releases the captured state without formatting it.  Must be called
+  // with the mutex locked, before the job is started.
+  void drop()
+  {
+    started = true;
+    dropped = true;
+    release();
+  }
+
+  // Releases everything that was only needed to format the text.  Must
+  // be called with the mutex locked.
+  void release()
+  {
+    log = LogSnapshot();
+    nodes = StringTable();
+    functions = StringTable();
+    files = StringTable();
+    std::set<size_t>().swap(expanded_entries);
+    rows.clear();
+    done = true;
+  }
+
+  // Formats unclaimed slices until there are none left or the token is
+  // cancelled.
+  void work(const CancelToken &token)
+  {
+    QMutexLocker lock(&mutex);
+    LogSnapshot local_log = log;
+    while (next_slice < slices.size() && !token.isCancelled()) {
+      size_t slice = next_slice++;
+      running++;
+      lock.unlock();
+
+      QString formatted = formatSlice(local_log, slice);
+
+      lock.relock();
+      slices[slice].swap(formatted);
+      running--;
+      if (running == 0 && next_slice == slices.size()) {
+        finish();
+      }
+    }
+  }
+
+  QString formatSlice(const LogSnapshot &local_log, size_t slice) const
+  {
+    size_t begin = slice * SLICE_SIZE;
+    size_t end = std::min(line_count, begin + SLICE_SIZE);
+
+    // Find the range and row of the slice's first line.
+    size_t range = std::upper_bound(range_offsets.begin(), range_offsets.end(), begin) -
+      range_offsets.begin() - 1;
+    int row = ranges[range].first + static_cast<int>(begin - range_offsets[range]);
+
+    QStringList buffer;
+    buffer.reserve(end - begin);
+    for (size_t i = begin; i < end; i++, row++) {
+      if (row > ranges[range].second) {
+        range++;
+        row = ranges[range].first;
+      }
+      const LogDatabaseProxyModel::LineMap &line = rows[row];
+      const LogEntry &entry = local_log[line.log_index];
+      if (role == LogDatabaseProxyModel::ExtendedLogRole) {
+        buffer << formatExtendedLog(entry, nodes, functions, files);
+      } else {
+        const bool collapsed = (entry.text.size() > 1 &&
+                                expanded_entries.count(line.log_index) == 0);
+        buffer << formatLogLine(entry,
+                                line.line_index,
+                                collapsed,
+                                role == LogDatabaseProxyModel::FullTextRole,
+                                format,
+                                nodes,
+                                functions);
+      }
+    }
+    return buffer.join(separator);
+  }
+};
+
+namespace
+{
+class FormatTask : public QRunnable
+{
+ public:
+  FormatTask(const boost::shared_ptr<LogMimeData::Job> &job,
+             const CancelToken &token) :
+    job_(job),
+    token_(token)
+  {
+  }
+
+  void run()
+  {
+    job_->work(token_);
+  }
+
+ private:
+  boost::shared_ptr<LogMimeData::Job> job_;
+  CancelToken token_;
+};
+}  // namespace
+
+LogMimeData::LogMimeData(
+  const LogDatabase *db,
+  const LogLineFormat &format,
+  const std::set<size_t> &expanded_entries,
+  const ChunkedList<LogDatabaseProxyModel::LineMap> &rows,
+  const std::vector<std::pair<int, int> > &ranges,
+  int role,
+  const QString &separator)
+  :
+  job_(new Job()),
+  executor_(db->executor())
+{
+  // The snapshot, the tables, and the rows share their data with the
+  // database and the model, so the only real copy here is the expanded
+  // set.
+  job_->log = db->log().snapshot();
+  job_->nodes = db->nodes();
+  job_->functions = db->functions();
+  job_->files = db->files();
+  job_->format = format;
+  job_->expanded_entries = expanded_entries;
+  job_->rows = rows;
+  job_->ranges = ranges;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    job_->range_offsets.push_back(job_->line_count);
+    job_->line_count += ranges[i].second - ranges[i].first + 1;
+  }
+  job_->role = role;
+  job_->separator = separator;
+
+  QObject::connect(db, SIGNAL(databaseCleared()),
+                   this, SLOT(handleDatabaseCleared()));
+}
+
+LogMimeData::~LogMimeData()
+{
+  // Stop any workers that are still helping with the text.
+  cancel_token_.cancel();
+}
+
+QStringList LogMimeData::formats() const
+{
+  QMutexLocker lock(&job_->mutex);
+  if (job_->dropped) {
+    return QStringList();
+  }
+  return QStringList(TEXT_MIME_TYPE);
+}
+
+QVariant LogMimeData::retrieveData(const QString &mimetype, QVariant::Type type) const
+{
+  if (mimetype != TEXT_MIME_TYPE) {
+    return QMimeData::retrieveData(mimetype, type);
+  }
+
+  Job &job = *job_;
+  {
+    QMutexLocker lock(&job.mutex);
+    if (job.dropped) {
+      return QVariant();
+    }
+    job.start();
+    if (job.done) {
+      return QVariant(job.text);
+    }
+  }
+
+  // The clipboard may hand its data to the system when the application
+  // exits, after the executor is gone, so only ask for help while the
+  // application is running.
+  if (executor_ && !QCoreApplication::closingDown()) {
+    // This thread takes one of the slices itself.
+    size_t threads = std::min(job.sliceCount(),
+                              static_cast<size_t>(executor_->threadCount()));
+    for (size_t i = 1; i < threads; i++) {
+      executor_->submit(new FormatTask(job_, cancel_token_),
+                        TaskExecutor::INTERACTIVE,
+                        cancel_token_);
+    }
+  }
+
+  job.work(CancelToken());
+
+  // The slices that workers are still formatting are the only ones left.
+  QMutexLocker lock(&job.mutex);
+  while (!job.done) {
+    job.finished.wait(&job.mutex);
+  }
+  return QVariant(job.text);
+}
+
+void LogMimeData::handleDatabaseCleared()
+{
+  {
+    QMutexLocker lock(&job_->mutex);
+    if (job_->started) {
+      return;
+    }
+    if (job_->line_count > KEEP_LINES_ON_CLEAR) {
+      job_->drop();
+      return;
+    }
+  }
+  retrieveData(TEXT_MIME_TYPE, QVariant::String);
+}
+}  // namespace swri_console
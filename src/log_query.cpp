@@ -0,0 +1,894 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/log_query.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <QRegExp>
+#include <QStringList>
+
+#include <rosgraph_msgs/Log.h>
+
+#include <swri_console/log_database.h>
+#include <swri_console/regexp_prefilter.h>
+
+namespace swri_console
+{
+// Relative cost of evaluating each kind of predicate on one entry.  Only
+// the ratios matter to the planner.
+static const double LEVEL_COST = 1.0;
+static const double TIME_COST = 1.0;
+static const double FIELD_COST = 2.0;
+static const double SUBSTRING_COST = 20.0;
+static const double WILDCARD_COST = 50.0;
+static const double REGEXP_COST = 100.0;
+
+// Number of recent entries used to estimate the selectivity of message
+// predicates, which have no precomputed statistics.
+static const size_t MESSAGE_SAMPLE_SIZE = 256;
+static const double DEFAULT_SELECTIVITY = 0.5;
+
+static const uint8_t LEVELS[] = {
+  rosgraph_msgs::Log::DEBUG,
+  rosgraph_msgs::Log::INFO,
+  rosgraph_msgs::Log::WARN,
+  rosgraph_msgs::Log::ERROR,
+  rosgraph_msgs::Log::FATAL
+};
+static const char *LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+static const size_t NUM_LEVELS = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+class QueryNode
+{
+ public:
+  QueryNode() : cost(1.0), selectivity(DEFAULT_SELECTIVITY) {}
+  virtual ~QueryNode() {}
+
+  virtual bool evaluate(const LogEntry &entry) = 0;
+
+  // Returns false if no entry in a chunk with this summary can be
+  // accepted by the subtree.
+  virtual bool mayMatch(const LogChunkSummary &) { return true; }
+
+  // Orders the subtree for evaluation and updates the estimates below.
+  virtual void plan(const LogDatabase &db) = 0;
+
+  // Expected cost of evaluating the subtree for one entry.
+  double cost;
+  // Expected fraction of entries that the subtree accepts.
+  double selectivity;
+};
+
+typedef boost::shared_ptr<QueryNode> QueryNodePtr;
+
+namespace
+{
+struct TextMatcher
+{
+  enum Type { SUBSTRING, WILDCARD, REGEXP };
+
+  TextMatcher(Type t, const QString &p) :
+    type(t),
+    pattern(p)
+  {
+    if (type == WILDCARD) {
+      regexp = QRegExp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard);
+    } else if (type == REGEXP) {
+      regexp = QRegExp(pattern);
+      prefilter.setRegExp(regexp);
+    }
+  }
+
+  bool matches(const QString &value) const
+  {
+    switch (type) {
+      case SUBSTRING:
+        return value.contains(pattern, Qt::CaseInsensitive);
+      case WILDCARD:
+        return regexp.exactMatch(value);
+      default:
+        return prefilter.mayMatch(value) && regexp.indexIn(value) >= 0;
+    }
+  }
+
+  double cost() const
+  {
+    switch (type) {
+      case SUBSTRING:
+        return SUBSTRING_COST;
+      case WILDCARD:
+        return WILDCARD_COST;
+      default:
+        return REGEXP_COST;
+    }
+  }
+
+  Type type;
+  QString pattern;
+  QRegExp regexp;
+  RegExpPrefilter prefilter;
+};
+
+class LevelPredicate : public QueryNode
+{
+ public:
+  explicit LevelPredicate(uint8_t mask) : mask_(mask) {}
+
+  bool evaluate(const LogEntry &entry)
+  {
+    return (entry.level & mask_) != 0;
+  }
+
+  bool mayMatch(const LogChunkSummary &summary)
+  {
+    return summary.hasLevel(mask_);
+  }
+
+  void plan(const LogDatabase &db)
+  {
+    cost = LEVEL_COST;
+    selectivity = DEFAULT_SELECTIVITY;
+    if (db.log().empty()) {
+      return;
+    }
+
+    size_t matched = 0;
+    for (size_t i = 0; i < NUM_LEVELS; i++) {
+      if (LEVELS[i] & mask_) {
+        matched += db.levelCount(LEVELS[i]);
+      }
+    }
+    selectivity = static_cast<double>(matched) / db.log().size();
+  }
+
+ private:
+  uint8_t mask_;
+};
+
+// A comparison of the stamp with a time in seconds since the start of
+// the log, which is what the time column shows by default.  The start
+// can move back when older messages are loaded, so the threshold is
+// resolved against the database on every use.
+class TimePredicate : public QueryNode
+{
+ public:
+  enum Comparison { BEFORE, AT_OR_BEFORE, AFTER, AT_OR_AFTER };
+
+  TimePredicate(const LogDatabase *db, Comparison comparison, double seconds) :
+    db_(db),
+    comparison_(comparison),
+    seconds_(seconds)
+  {
+  }
+
+  bool evaluate(const LogEntry &entry)
+  {
+    return compare(entry.stamp.toSec(), threshold());
+  }
+
+  bool mayMatch(const LogChunkSummary &summary)
+  {
+    // Only the end of the chunk's range nearest the accepted side
+    // matters.
+    double limit = threshold();
+    if (comparison_ == BEFORE || comparison_ == AT_OR_BEFORE) {
+      return compare(summary.minStamp().toSec(), limit);
+    }
+    return compare(summary.maxStamp().toSec(), limit);
+  }
+
+  void plan(const LogDatabase &db)
+  {
+    cost = TIME_COST;
+    selectivity = DEFAULT_SELECTIVITY;
+    if (db.log().empty()) {
+      return;
+    }
+
+    // Assume that the messages are spread evenly over the log.
+    double span = (db.maxTime() - db.minTime()).toSec();
+    if (span <= 0.0) {
+      return;
+    }
+    double before = std::min(1.0, std::max(0.0, seconds_ / span));
+    if (comparison_ == BEFORE || comparison_ == AT_OR_BEFORE) {
+      selectivity = before;
+    } else {
+      selectivity = 1.0 - before;
+    }
+  }
+
+ private:
+  double threshold() const
+  {
+    return db_->minTime().toSec() + seconds_;
+  }
+
+  bool compare(double stamp, double threshold) const
+  {
+    switch (comparison_) {
+      case BEFORE:
+        return stamp < threshold;
+      case AT_OR_BEFORE:
+        return stamp <= threshold;
+      case AFTER:
+        return stamp > threshold;
+      default:
+        return stamp >= threshold;
+    }
+  }
+
+  const LogDatabase *db_;
+  Comparison comparison_;
+  double seconds_;
+};
+
+// A predicate on one of the interned fields.  Like FieldFilter, it is
+// evaluated once per distinct value, and the per-value counts of the
+// database give its exact selectivity.
+class FieldPredicate : public QueryNode
+{
+ public:
+  enum Field { NODE, FILE, FUNCTION };
+
+  FieldPredicate(const LogDatabase *db, Field field, const TextMatcher &matcher) :
+    db_(db),
+    field_(field),
+    matcher_(matcher),
+    generation_(0)
+  {
+  }
+
+  bool evaluate(const LogEntry &entry)
+  {
+    uint32_t id = (field_ == NODE ? entry.node_id :
+                   field_ == FILE ? entry.file_id :
+                   entry.function_id);
+    if (id >= verdicts_.size() || values().generation() != generation_) {
+      update();
+    }
+    return verdicts_[id];
+  }
+
+  void plan(const LogDatabase &db)
+  {
+    cost = FIELD_COST;
+    update();
+
+    const std::vector<size_t> &counts = (field_ == NODE ? db.nodeCounts() :
+                                         field_ == FILE ? db.fileCounts() :
+                                         db.functionCounts());
+    size_t total = 0;
+    size_t matched = 0;
+    for (size_t i = 0; i < counts.size() && i < verdicts_.size(); i++) {
+      total += counts[i];
+      if (verdicts_[i]) {
+        matched += counts[i];
+      }
+    }
+    selectivity = total ? static_cast<double>(matched) / total : DEFAULT_SELECTIVITY;
+  }
+
+ private:
+  const StringTable& values() const
+  {
+    return (field_ == NODE ? db_->nodes() :
+            field_ == FILE ? db_->files() :
+            db_->functions());
+  }
+
+  void update()
+  {
+    const StringTable &table = values();
+    if (table.generation() != generation_) {
+      // The database was cleared and the IDs were reassigned.
+      verdicts_.clear();
+      generation_ = table.generation();
+    }
+    for (size_t i = verdicts_.size(); i < table.size(); i++) {
+      verdicts_.push_back(matcher_.matches(QString::fromStdString(table.value(i))));
+    }
+  }
+
+  const LogDatabase *db_;
+  Field field_;
+  TextMatcher matcher_;
+  std::vector<bool> verdicts_;
+  uint32_t generation_;
+};
+
+// A predicate on the message text.  The verdict is cached per distinct
+// text, so repeated messages are only matched once.
+class MessagePredicate : public QueryNode
+{
+ public:
+  MessagePredicate(const LogDatabase *db, const TextMatcher &matcher) :
+    db_(db),
+    matcher_(matcher),
+    generation_(0)
+  {
+  }
+
+  bool evaluate(const LogEntry &entry)
+  {
+    if (db_->texts().generation() != generation_) {
+      verdicts_.clear();
+      generation_ = db_->texts().generation();
+    }
+    if (entry.text_id >= verdicts_.size()) {
+      verdicts_.resize(entry.text_id + 1);
+    }
+    CachedVerdict &cached = verdicts_[entry.text_id];
+    if (cached.verdict == UNKNOWN || cached.version != entry.text_version) {
+      // Multi-line messages are joined with spaces, like the include and
+      // exclude filters do.
+      cached.verdict = matcher_.matches(entry.text.join(" ")) ? MATCHED : UNMATCHED;
+      cached.version = entry.text_version;
+    }
+    return cached.verdict == MATCHED;
+  }
+
+  bool mayMatch(const LogChunkSummary &summary)
+  {
+    // Wildcards and regexps have no literal text to look up.
+    return (matcher_.type != TextMatcher::SUBSTRING ||
+            summary.mayContain(matcher_.pattern));
+  }
+
+  void plan(const LogDatabase &db)
+  {
+    cost = matcher_.cost();
+
+    const LogStore &log = db.log();
+    size_t samples = std::min(log.size(), MESSAGE_SAMPLE_SIZE);
+    size_t matched = 0;
+    for (size_t i = log.size() - samples; i < log.size(); i++) {
+      if (evaluate(log[i])) {
+        matched++;
+      }
+    }
+    // Smoothed so that a small sample never claims that a predicate
+    // accepts everything or nothing.
+    selectivity = (matched + 1.0) / (samples + 2.0);
+  }
+
+ private:
+  enum Verdict { UNKNOWN, MATCHED, UNMATCHED };
+
+  // A verdict and the version of the text ID that it was found for.
+  struct CachedVerdict
+  {
+    uint32_t version;
+    uint8_t verdict;
+
+    CachedVerdict() : version(0), verdict(UNKNOWN) {}
+  };
+
+  const LogDatabase *db_;
+  TextMatcher matcher_;
+  std::vector<CachedVerdict> verdicts_;
+  uint32_t generation_;
+};
+
+class NotNode : public QueryNode
+{
+ public:
+  explicit NotNode(const QueryNodePtr &child) : child_(child) {}
+
+  bool evaluate(const LogEntry &entry)
+  {
+    return !child_->evaluate(entry);
+  }
+
+  void plan(const LogDatabase &db)
+  {
+    child_->plan(db);
+    cost = child_->cost;
+    selectivity = 1.0 - child_->selectivity;
+  }
+
+ private:
+  QueryNodePtr child_;
+};
+
+// For a conjunction, evaluating a before b is cheaper on average when
+// cost(a) / (1 - sel(a)) < cost(b) / (1 - sel(b)).  The comparison is
+// cross-multiplied to avoid dividing by zero.
+static bool rejectsCheaper(const QueryNodePtr &a, const QueryNodePtr &b)
+{
+  return a->cost * (1.0 - b->selectivity) < b->cost * (1.0 - a->selectivity);
+}
+
+// For a disjunction, the rank is cost / sel instead.
+static bool acceptsCheaper(const QueryNodePtr &a, const QueryNodePtr &b)
+{
+  return a->cost * b->selectivity < b->cost * a->selectivity;
+}
+
+// An "and" or "or" of any number of children, which are evaluated in
+// the order chosen by the planner and short-circuit.
+class CompoundNode : public QueryNode
+{
+ public:
+  explicit CompoundNode(bool conjunction) : conjunction_(conjunction) {}
+
+  bool isConjunction() const { return conjunction_; }
+
+  void addChild(const QueryNodePtr &child)
+  {
+    // Flatten nested nodes of the same kind so that the planner can
+    // order all of their children together.
+    CompoundNode *compound = dynamic_cast<CompoundNode*>(child.get());
+    if (compound && compound->conjunction_ == conjunction_) {
+      children_.insert(children_.end(),
+                       compound->children_.begin(),
+                       compound->children_.end());
+    } else {
+      children_.push_back(child);
+    }
+  }
+
+  bool evaluate(const LogEntry &entry)
+  {
+    for (size_t i = 0; i < children_.size(); i++) {
+      if (children_[i]->evaluate(entry) != conjunction_) {
+        return !conjunction_;
+      }
+    }
+    return conjunction_;
+  }
+
+  bool mayMatch(const LogChunkSummary &summary)
+  {
+    for (size_t i = 0; i < children_.size(); i++) {
+      if (children_[i]->mayMatch(summary) != conjunction_) {
+        return !conjunction_;
+      }
+    }
+    return conjunction_;
+  }
+
+  void plan(const LogDatabase &db)
+  {
+    for (size_t i = 0; i < children_.size(); i++) {
+      children_[i]->plan(db);
+    }
+    std::stable_sort(children_.begin(), children_.end(),
+                     conjunction_ ? rejectsCheaper : acceptsCheaper);
+
+    // Each child is only evaluated if the previous ones didn't decide
+    // the result.
+    cost = 0.0;
+    double reached = 1.0;
+    for (size_t i = 0; i < children_.size(); i++) {
+      cost += reached * children_[i]->cost;
+      if (conjunction_) {
+        reached *= children_[i]->selectivity;
+      } else {
+        reached *= 1.0 - children_[i]->selectivity;
+      }
+    }
+    selectivity = conjunction_ ? reached : 1.0 - reached;
+  }
+
+ private:
+  bool conjunction_;
+  std::vector<QueryNodePtr> children_;
+};
+
+class QueryParser
+{
+ public:
+  QueryParser(const LogDatabase *db, const QString &text) :
+    db_(db),
+    text_(text),
+    pos_(0)
+  {
+  }
+
+  QueryNodePtr parse()
+  {
+    QueryNodePtr node = parseOr();
+    skipSpace();
+    if (node && pos_ < text_.size()) {
+      return fail(QString("Unexpected '%1'").arg(text_[pos_]));
+    }
+    return node;
+  }
+
+  const QString& error() const { return error_; }
+
+ private:
+  QueryNodePtr fail(const QString &message)
+  {
+    if (error_.isEmpty()) {
+      error_ = QString("%1 at position %2").arg(message).arg(pos_ + 1);
+    }
+    return QueryNodePtr();
+  }
+
+  void skipSpace()
+  {
+    while (pos_ < text_.size() && text_[pos_].isSpace()) {
+      pos_++;
+    }
+  }
+
+  static bool isWordChar(const QChar &c)
+  {
+    return c.isLetterOrNumber() || c == '_';
+  }
+
+  // Consumes a keyword such as "and" if it is next in the text.
+  bool takeKeyword(const QString &keyword)
+  {
+    skipSpace();
+    if (text_.midRef(pos_, keyword.size()).compare(keyword, Qt::CaseInsensitive) != 0) {
+      return false;
+    }
+    int end = pos_ + keyword.size();
+    if (end < text_.size() && isWordChar(text_[end])) {
+      return false;
+    }
+    pos_ = end;
+    return true;
+  }
+
+  QString takeIdentifier()
+  {
+    int start = pos_;
+    while (pos_ < text_.size() && isWordChar(text_[pos_])) {
+      pos_++;
+    }
+    return text_.mid(start, pos_ - start).toLower();
+  }
+
+  // Consumes a quoted string or a bare word, which extends to the next
+  // space or parenthesis.  Returns false on an unterminated string.
+  bool takeValue(QString *value)
+  {
+    skipSpace();
+    value->clear();
+    if (pos_ < text_.size() && text_[pos_] == '"') {
+      pos_++;
+      while (pos_ < text_.size() && text_[pos_] != '"') {
+        // Only \" is an escape; other backslashes are kept so that
+        // regular expressions can be quoted as-is.
+        if (text_[pos_] == '\\' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '"') {
+          pos_++;
+        }
+        value->append(text_[pos_]);
+        pos_++;
+      }
+      if (pos_ >= text_.size()) {
+        return false;
+      }
+      pos_++;
+      return true;
+    }
+
+    while (pos_ < text_.size() &&
+           !text_[pos_].isSpace() &&
+           text_[pos_] != '(' &&
+           text_[pos_] != ')') {
+      value->append(text_[pos_]);
+      pos_++;
+    }
+    return true;
+  }
+
+  QueryNodePtr parseOr()
+  {
+    QueryNodePtr node = parseAnd();
+    if (!node) {
+      return node;
+    }
+
+    boost::shared_ptr<CompoundNode> compound;
+    while (takeKeyword("or")) {
+      QueryNodePtr rhs = parseAnd();
+      if (!rhs) {
+        return rhs;
+      }
+      if (!compound) {
+        compound.reset(new CompoundNode(false));
+        compound->addChild(node);
+      }
+      compound->addChild(rhs);
+    }
+    return compound ? compound : node;
+  }
+
+  QueryNodePtr parseAnd()
+  {
+    QueryNodePtr node = parseUnary();
+    if (!node) {
+      return node;
+    }
+
+    boost::shared_ptr<CompoundNode> compound;
+    while (takeKeyword("and")) {
+      QueryNodePtr rhs = parseUnary();
+      if (!rhs) {
+        return rhs;
+      }
+      if (!compound) {
+        compound.reset(new CompoundNode(true));
+        compound->addChild(node);
+      }
+      compound->addChild(rhs);
+    }
+    return compound ? compound : node;
+  }
+
+  QueryNodePtr parseUnary()
+  {
+    skipSpace();
+    if (pos_ >= text_.size()) {
+      return fail("Expected a predicate");
+    }
+
+    if (takeKeyword("not")) {
+      QueryNodePtr child = parseUnary();
+      if (!child) {
+        return child;
+      }
+      return QueryNodePtr(new NotNode(child));
+    }
+
+    if (text_[pos_] == '(') {
+      pos_++;
+      QueryNodePtr node = parseOr();
+      if (!node) {
+        return node;
+      }
+      skipSpace();
+      if (pos_ >= text_.size() || text_[pos_] != ')') {
+        return fail("Expected ')'");
+      }
+      pos_++;
+      return node;
+    }
+
+    return parsePredicate();
+  }
+
+  QueryNodePtr parsePredicate()
+  {
+    int start = pos_;
+    QString field = takeIdentifier();
+    skipSpace();
+    if (field.isEmpty() ||
+        pos_ >= text_.size() ||
+        QString(":~=!<>").indexOf(text_[pos_]) < 0) {
+      // Not a field predicate, so it's a message substring.
+      pos_ = start;
+      QString value;
+      if (!takeValue(&value)) {
+        return fail("Unterminated string");
+      }
+      if (value.isEmpty()) {
+        return fail("Expected a predicate");
+      }
+      return QueryNodePtr(new MessagePredicate(db_, TextMatcher(TextMatcher::SUBSTRING, value)));
+    }
+
+    if (field == "level") {
+      return parseLevel();
+    } else if (field == "time") {
+      return parseTime();
+    }
+
+    FieldPredicate::Field id = FieldPredicate::NODE;
+    bool is_message = false;
+    if (field == "node") {
+      id = FieldPredicate::NODE;
+    } else if (field == "file") {
+      id = FieldPredicate::FILE;
+    } else if (field == "function") {
+      id = FieldPredicate::FUNCTION;
+    } else if (field == "msg" || field == "message") {
+      is_message = true;
+    } else {
+      return fail(QString("Unknown field '%1'").arg(field));
+    }
+
+    QChar op = text_[pos_];
+    if (op != ':' && op != '~') {
+      return fail(QString("Expected ':' or '~' after '%1'").arg(field));
+    }
+    pos_++;
+
+    QString pattern;
+    if (!takeValue(&pattern)) {
+      return fail("Unterminated string");
+    }
+    if (pattern.isEmpty()) {
+      return fail(QString("Expected a pattern after '%1%2'").arg(field).arg(op));
+    }
+
+    TextMatcher::Type type = TextMatcher::REGEXP;
+    if (op == ':') {
+      type = (pattern.contains('*') || pattern.contains('?')) ?
+        TextMatcher::WILDCARD : TextMatcher::SUBSTRING;
+    }
+    TextMatcher matcher(type, pattern);
+    if (type == TextMatcher::REGEXP && !matcher.regexp.isValid()) {
+      return fail(QString("Invalid regular expression (%1)").arg(matcher.regexp.errorString()));
+    }
+
+    if (is_message) {
+      return QueryNodePtr(new MessagePredicate(db_, matcher));
+    }
+    return QueryNodePtr(new FieldPredicate(db_, id, matcher));
+  }
+
+  QueryNodePtr parseLevel()
+  {
+    static const char *OPERATORS[] = {">=", "<=", "!=", "==", "=", "<", ">", ":"};
+
+    QString op;
+    for (size_t i = 0; i < sizeof(OPERATORS) / sizeof(OPERATORS[0]); i++) {
+      if (text_.midRef(pos_).startsWith(OPERATORS[i])) {
+        op = OPERATORS[i];
+        break;
+      }
+    }
+    if (op.isEmpty()) {
+      return fail("Expected a comparison after 'level'");
+    }
+    pos_ += op.size();
+
+    QString name;
+    takeValue(&name);
+    int level = -1;
+    for (size_t i = 0; i < NUM_LEVELS; i++) {
+      if (name.compare(LEVEL_NAMES[i], Qt::CaseInsensitive) == 0) {
+        level = i;
+      }
+    }
+    if (level < 0) {
+      return fail(QString("Unknown level '%1'").arg(name));
+    }
+
+    // The levels are ordered by severity, so comparisons select a range.
+    uint8_t mask = 0;
+    for (int i = 0; i < static_cast<int>(NUM_LEVELS); i++) {
+      bool accepted = ((op == ">=" && i >= level) ||
+                       (op == "<=" && i <= level) ||
+                       (op == ">" && i > level) ||
+                       (op == "<" && i < level) ||
+                       (op == "!=" && i != level) ||
+                       ((op == "=" || op == "==" || op == ":") && i == level));
+      if (accepted) {
+        mask |= LEVELS[i];
+      }
+    }
+    return QueryNodePtr(new LevelPredicate(mask));
+  }
+
+  QueryNodePtr parseTime()
+  {
+    static const char *OPERATORS[] = {">=", "<=", "<", ">"};
+    static const TimePredicate::Comparison COMPARISONS[] = {
+      TimePredicate::AT_OR_AFTER,
+      TimePredicate::AT_OR_BEFORE,
+      TimePredicate::BEFORE,
+      TimePredicate::AFTER
+    };
+
+    int op = -1;
+    for (size_t i = 0; i < sizeof(OPERATORS) / sizeof(OPERATORS[0]) && op < 0; i++) {
+      if (text_.midRef(pos_).startsWith(OPERATORS[i])) {
+        op = i;
+      }
+    }
+    if (op < 0) {
+      return fail("Expected <, <=, > or >= after 'time'");
+    }
+    pos_ += QString(OPERATORS[op]).size();
+
+    QString value;
+    takeValue(&value);
+    bool ok = false;
+    double seconds = value.toDouble(&ok);
+    if (!ok) {
+      return fail(QString("Expected a number of seconds, not '%1'").arg(value));
+    }
+    return QueryNodePtr(new TimePredicate(db_, COMPARISONS[op], seconds));
+  }
+
+  const LogDatabase *db_;
+  QString text_;
+  int pos_;
+  QString error_;
+};
+}  // namespace
+
+LogQuery::LogQuery(const LogDatabase *db)
+  :
+  db_(db),
+  planned_size_(0)
+{
+}
+
+LogQuery::~LogQuery()
+{
+}
+
+bool LogQuery::parse(const QString &text)
+{
+  text_ = text;
+  error_.clear();
+  root_.reset();
+
+  if (text.trimmed().isEmpty()) {
+    return true;
+  }
+
+  QueryParser parser(db_, text);
+  root_ = parser.parse();
+  if (!root_) {
+    error_ = parser.error();
+    return false;
+  }
+
+  plan();
+  return true;
+}
+
+void LogQuery::plan()
+{
+  planned_size_ = db_->log().size();
+  if (root_) {
+    root_->plan(*db_);
+  }
+}
+
+void LogQuery::refreshPlan()
+{
+  size_t size = db_->log().size();
+  if (size > 2 * planned_size_ || size < planned_size_ / 2) {
+    plan();
+  }
+}
+
+bool LogQuery::accepts(const LogEntry &entry)
+{
+  return !root_ || root_->evaluate(entry);
+}
+
+bool LogQuery::mayMatch(const LogChunkSummary &summary)
+{
+  return !root_ || root_->mayMatch(summary);
+}
+}  // namespace swri_console
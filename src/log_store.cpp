@@ -0,0 +1,379 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/log_store.h>
+
+#include <map>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QMutex>
+#include <QRunnable>
+
+#include <swri_console/log_database.h>
+#include <swri_console/task_executor.h>
+
+namespace swri_console
+{
+const size_t LogStore::CHUNK_SIZE;
+const size_t DecodedChunkCache::CACHE_SIZE;
+
+// Number of full chunks at the end of the log that are kept
+// uncompressed, since new entries are the most likely to be viewed.
+static const size_t HOT_CHUNK_COUNT = 64;
+
+struct LogStoreChunk
+{
+  LogStoreChunk() : entries(LogStore::CHUNK_SIZE) {}
+  explicit LogStoreChunk(const QByteArray &data) : compressed(data) {}
+
+  // Allocated at full size up front so that entries never move.  Empty
+  // if the chunk is compressed.
+  std::vector<LogEntry> entries;
+  QByteArray compressed;
+};
+
+struct LogStoreState
+{
+  LogStoreState() : size(0) {}
+
+  std::vector<boost::shared_ptr<LogStoreChunk> > chunks;
+  size_t size;
+
+  const LogEntry& entry(size_t index, DecodedChunkCache &cache) const
+  {
+    const boost::shared_ptr<LogStoreChunk> &chunk = chunks[index / LogStore::CHUNK_SIZE];
+    if (chunk->compressed.isEmpty()) {
+      return chunk->entries[index % LogStore::CHUNK_SIZE];
+    }
+    return cache.entries(chunk)[index % LogStore::CHUNK_SIZE];
+  }
+};
+
+struct CompressedChunks
+{
+  struct Result
+  {
+    size_t index;
+    boost::shared_ptr<LogStoreChunk> original;
+    boost::shared_ptr<LogStoreChunk> compressed;
+  };
+
+  QMutex mutex;
+  std::vector<Result> results;
+};
+
+static QByteArray compressEntries(const std::vector<LogEntry> &entries)
+{
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+
+  // Each field is written as a column, since neighboring values of a
+  // field are similar and compress much better together than whole
+  // entries do.
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].stamp.sec);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].stamp.nsec);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint8(entries[i].level);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].node_id);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].file_id);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].function_id);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].line);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].seq);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].text_id);
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    stream << quint32(entries[i].text_version);
+  }
+
+  // Each distinct text is written once, in order of first use.
+  std::map<uint32_t, bool> written;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!written[entries[i].text_id]) {
+      written[entries[i].text_id] = true;
+      stream << entries[i].text;
+    }
+  }
+
+  return qCompress(data);
+}
+
+static void decompressEntries(const QByteArray &compressed, std::vector<LogEntry> *entries)
+{
+  QByteArray data = qUncompress(compressed);
+  QDataStream stream(data);
+
+  entries->resize(LogStore::CHUNK_SIZE);
+  quint32 value;
+  quint8 level;
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].stamp.sec = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].stamp.nsec = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> level;
+    (*entries)[i].level = level;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].node_id = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].file_id = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].function_id = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].line = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].seq = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].text_id = value;
+  }
+  for (size_t i = 0; i < entries->size(); i++) {
+    stream >> value;
+    (*entries)[i].text_version = value;
+  }
+
+  // Entries with the same text share one copy of it again.
+  std::map<uint32_t, QStringList> texts;
+  for (size_t i = 0; i < entries->size(); i++) {
+    LogEntry &entry = (*entries)[i];
+    std::map<uint32_t, QStringList>::iterator it = texts.find(entry.text_id);
+    if (it == texts.end()) {
+      it = texts.insert(std::make_pair(entry.text_id, QStringList())).first;
+      stream >> it->second;
+    }
+    entry.text = it->second;
+  }
+}
+
+namespace
+{
+class CompressChunkTask : public QRunnable
+{
+ public:
+  CompressChunkTask(const boost::shared_ptr<CompressedChunks> &results,
+                    size_t index,
+                    const boost::shared_ptr<LogStoreChunk> &chunk) :
+    results_(results)
+  {
+    result_.index = index;
+    result_.original = chunk;
+  }
+
+  void run()
+  {
+    // Full chunks are never modified, so they can be read here while
+    // the GUI thread reads them too.
+    result_.compressed.reset(new LogStoreChunk(compressEntries(result_.original->entries)));
+
+    QMutexLocker lock(&results_->mutex);
+    results_->results.push_back(result_);
+  }
+
+ private:
+  boost::shared_ptr<CompressedChunks> results_;
+  CompressedChunks::Result result_;
+};
+}  // namespace
+
+const std::vector<LogEntry>& DecodedChunkCache::entries(
+  const boost::shared_ptr<const LogStoreChunk> &chunk)
+{
+  for (size_t i = 0; i < chunks_.size(); i++) {
+    if (chunks_[i].first == chunk) {
+      if (i > 0) {
+        std::pair<boost::shared_ptr<const LogStoreChunk>,
+                  boost::shared_ptr<const std::vector<LogEntry> > > hit = chunks_[i];
+        chunks_.erase(chunks_.begin() + i);
+        chunks_.push_front(hit);
+      }
+      return *chunks_.front().second;
+    }
+  }
+
+  boost::shared_ptr<std::vector<LogEntry> > entries(new std::vector<LogEntry>());
+  decompressEntries(chunk->compressed, entries.get());
+  chunks_.push_front(std::make_pair(chunk, boost::shared_ptr<const std::vector<LogEntry> >(entries)));
+  if (chunks_.size() > CACHE_SIZE) {
+    chunks_.pop_back();
+  }
+  return *chunks_.front().second;
+}
+
+LogSnapshot::LogSnapshot()
+  :
+  state_(new LogStoreState())
+{
+}
+
+LogSnapshot::LogSnapshot(const boost::shared_ptr<const LogStoreState> &state)
+  :
+  state_(state)
+{
+}
+
+size_t LogSnapshot::size() const
+{
+  return state_->size;
+}
+
+const LogEntry& LogSnapshot::operator[](size_t index) const
+{
+  return state_->entry(index, cache_);
+}
+
+LogStore::LogStore()
+  :
+  state_(new LogStoreState()),
+  compressed_(new CompressedChunks()),
+  next_cold_chunk_(0)
+{
+}
+
+size_t LogStore::size() const
+{
+  return state_->size;
+}
+
+const LogEntry& LogStore::operator[](size_t index) const
+{
+  return state_->entry(index, cache_);
+}
+
+void LogStore::append(const std::deque<LogEntry> &entries)
+{
+  if (entries.empty()) {
+    return;
+  }
+
+  // Only the chunk list is copied.  The slots being filled are past the
+  // end of every published state, so no reader can be looking at them.
+  boost::shared_ptr<LogStoreState> state(new LogStoreState(*state_));
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (state->size % CHUNK_SIZE == 0) {
+      state->chunks.push_back(boost::shared_ptr<LogStoreChunk>(new LogStoreChunk()));
+    }
+    state->chunks.back()->entries[state->size % CHUNK_SIZE] = entries[i];
+    state->size++;
+  }
+
+  boost::shared_ptr<const LogStoreState> published(state);
+  boost::atomic_store(&state_, published);
+}
+
+void LogStore::clear(TaskExecutor *executor)
+{
+  boost::shared_ptr<const LogStoreState> old_state = state_;
+  boost::shared_ptr<const LogStoreState> empty(new LogStoreState());
+  boost::atomic_store(&state_, empty);
+  cache_ = DecodedChunkCache();
+  if (executor) {
+    executor->release(old_state);
+  }
+
+  // Compression results for the old chunks won't match anything in the
+  // new state, so they are dropped when they arrive.
+  next_cold_chunk_ = 0;
+}
+
+void LogStore::compressColdChunks(TaskExecutor *executor,
+                                  std::vector<uint32_t> *released_texts)
+{
+  std::vector<CompressedChunks::Result> results;
+  {
+    QMutexLocker lock(&compressed_->mutex);
+    results.swap(compressed_->results);
+  }
+
+  if (!results.empty()) {
+    boost::shared_ptr<LogStoreState> state(new LogStoreState(*state_));
+    bool installed = false;
+    for (size_t i = 0; i < results.size(); i++) {
+      const CompressedChunks::Result &result = results[i];
+      if (result.index < state->chunks.size() &&
+          state->chunks[result.index] == result.original) {
+        state->chunks[result.index] = result.compressed;
+        installed = true;
+        const std::vector<LogEntry> &entries = result.original->entries;
+        for (size_t j = 0; j < entries.size(); j++) {
+          released_texts->push_back(entries[j].text_id);
+        }
+      }
+    }
+    if (installed) {
+      boost::shared_ptr<const LogStoreState> published(state);
+      boost::atomic_store(&state_, published);
+    }
+  }
+
+  const size_t full_chunks = state_->size / CHUNK_SIZE;
+  for (; next_cold_chunk_ + HOT_CHUNK_COUNT < full_chunks; next_cold_chunk_++) {
+    executor->submit(new CompressChunkTask(compressed_,
+                                           next_cold_chunk_,
+                                           state_->chunks[next_cold_chunk_]),
+                     TaskExecutor::RECLAIM);
+  }
+}
+
+LogSnapshot LogStore::snapshot() const
+{
+  return LogSnapshot(boost::atomic_load(&state_));
+}
+}  // namespace swri_console
@@ -0,0 +1,117 @@
+// *****************************************************************************
+//
+// Copyright (c) 2016, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/logger_level_dialog.h>
+#include <swri_console/logger_service.h>
+
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+
+namespace swri_console
+{
+LoggerLevelDialog::LoggerLevelDialog(LoggerService *service,
+                                     const QStringList &nodes,
+                                     const QString &pattern,
+                                     const QString &level,
+                                     QWidget *parent) :
+  QDialog(parent),
+  request_id_(service->createRequestId()),
+  summary_(new QLabel(this)),
+  results_(new QListWidget(this)),
+  succeeded_(0),
+  failed_(0)
+{
+  setWindowTitle(QString("Set %1 loggers to %2").arg(pattern).arg(level));
+  setAttribute(Qt::WA_DeleteOnClose);
+
+  QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+  QObject::connect(buttons, SIGNAL(rejected()), this, SLOT(close()));
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->addWidget(summary_);
+  layout->addWidget(results_);
+  layout->addWidget(buttons);
+
+  QObject::connect(
+    service, SIGNAL(matchingLevelSet(int, const QString&, const QString&, int, bool, const QString&)),
+    this, SLOT(handleMatchingLevelSet(int, const QString&, const QString&, int, bool, const QString&)));
+
+  for (int i = 0; i < nodes.size(); i++) {
+    if (pending_.count(nodes[i])) {
+      continue;
+    }
+    QListWidgetItem *item = new QListWidgetItem(nodes[i] + ": pending", results_);
+    pending_[nodes[i]] = item;
+    service->setMatchingLoggerLevel(request_id_, nodes[i], pattern, level);
+  }
+
+  updateSummary();
+}
+
+void LoggerLevelDialog::handleMatchingLevelSet(int request_id,
+                                               const QString &node,
+                                               const QString &level,
+                                               int logger_count,
+                                               bool success,
+                                               const QString &error)
+{
+  // The results of every dialog are delivered here, so skip those of
+  // other requests even if they are for the same node and level.
+  if (request_id != request_id_) {
+    return;
+  }
+  std::map<QString, QListWidgetItem*>::iterator it = pending_.find(node);
+  if (it == pending_.end()) {
+    return;
+  }
+
+  QListWidgetItem *item = it->second;
+  pending_.erase(it);
+
+  if (success) {
+    succeeded_++;
+    item->setText(QString("%1: set %2 logger(s)").arg(node).arg(logger_count));
+  } else {
+    failed_++;
+    item->setText(QString("%1: %2").arg(node).arg(error));
+    item->setForeground(Qt::red);
+  }
+
+  updateSummary();
+}
+
+void LoggerLevelDialog::updateSummary()
+{
+  summary_->setText(QString("%1 succeeded, %2 failed, %3 pending")
+                    .arg(succeeded_)
+                    .arg(failed_)
+                    .arg(static_cast<int>(pending_.size())));
+}
+}  // namespace swri_console
@@ -0,0 +1,398 @@
+// *****************************************************************************
+//
+// Copyright (c) 2016, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/logger_service.h>
+
+#include <QMetaObject>
+#include <QRegExp>
+#include <QRunnable>
+
+#include <roscpp/GetLoggers.h>
+#include <roscpp/SetLoggerLevel.h>
+
+namespace swri_console
+{
+// How long a logger list is considered fresh.  Levels changed by other
+// tools after this are picked up the next time the menu is opened.
+static const qint64 LOGGER_CACHE_TTL_MS = 30000;
+
+// Normally the service lookup should return very quickly, but the
+// roscore may be stuck or reached over a slow network link, so the value
+// shouldn't be *too* small.
+static const double SERVICE_WAIT_SECS = 2.0;
+
+// Limits the number of nodes that are called at the same time during
+// bulk changes, so that quieting many nodes doesn't flood the network
+// or spawn an unbounded number of threads.
+static const int MAX_CONCURRENT_CALLS = 8;
+
+static const std::string GET_LOGGERS_SVC = "/get_loggers";
+static const std::string SET_LOGGER_LEVEL_SVC = "/set_logger_level";
+
+namespace
+{
+class GetLoggersTask : public QRunnable
+{
+ public:
+  // Prefetches pass a token so that they can be dropped when the
+  // selection changes.
+  GetLoggersTask(LoggerService *service,
+                 const QString &node,
+                 bool prefetch = false,
+                 const CancelToken &token = CancelToken()) :
+    service_(service),
+    node_(node),
+    prefetch_(prefetch),
+    token_(token)
+  {
+  }
+
+  void run()
+  {
+    if (token_.isCancelled()) {
+      return;
+    }
+
+    QStringList names;
+    QStringList levels;
+    bool success = false;
+    QString error;
+
+    std::string service_name = node_.toStdString() + GET_LOGGERS_SVC;
+    ros::NodeHandle nh;
+    ros::ServiceClient client = nh.serviceClient<roscpp::GetLoggers>(service_name);
+    roscpp::GetLoggers srv;
+
+    ROS_DEBUG("Getting loggers for %s...", node_.toStdString().c_str());
+    if (!client.waitForExistence(ros::Duration(SERVICE_WAIT_SECS))) {
+      ROS_WARN("Timed out while waiting for service at %s.", service_name.c_str());
+      error = "Timed out waiting for get_loggers service.";
+    } else if (token_.isCancelled()) {
+      return;
+    } else if (!LoggerService::callService(client, srv)) {
+      ROS_WARN("Service call to %s failed.", service_name.c_str());
+      error = "Service call to get_loggers failed.";
+    } else {
+      success = true;
+      for (size_t i = 0; i < srv.response.loggers.size(); i++) {
+        const roscpp::Logger &logger = srv.response.loggers[i];
+        ROS_DEBUG("Log level for %s is %s", logger.name.c_str(), logger.level.c_str());
+        names.append(QString::fromStdString(logger.name));
+        levels.append(QString::fromStdString(logger.level));
+      }
+    }
+
+    QMetaObject::invokeMethod(service_, "handleLoggers", Qt::QueuedConnection,
+                              Q_ARG(QString, node_),
+                              Q_ARG(QStringList, names),
+                              Q_ARG(QStringList, levels),
+                              Q_ARG(bool, success),
+                              Q_ARG(QString, error),
+                              Q_ARG(bool, prefetch_));
+  }
+
+ private:
+  LoggerService *service_;
+  QString node_;
+  bool prefetch_;
+  CancelToken token_;
+};
+
+class SetLoggerLevelTask : public QRunnable
+{
+ public:
+  SetLoggerLevelTask(LoggerService *service,
+                     const QString &node,
+                     const QStringList &loggers,
+                     const QString &level) :
+    service_(service),
+    node_(node),
+    loggers_(loggers),
+    level_(level)
+  {
+  }
+
+  void run()
+  {
+    bool success = true;
+    QString error;
+
+    std::string service_name = node_.toStdString() + SET_LOGGER_LEVEL_SVC;
+    ros::NodeHandle nh;
+    ros::ServiceClient client = nh.serviceClient<roscpp::SetLoggerLevel>(service_name);
+
+    if (!client.waitForExistence(ros::Duration(SERVICE_WAIT_SECS))) {
+      ROS_WARN("Timed out while waiting for service at %s.", service_name.c_str());
+      success = false;
+      error = "Timed out waiting for set_logger_level service.";
+    } else {
+      for (int i = 0; i < loggers_.size(); i++) {
+        roscpp::SetLoggerLevel srv;
+        srv.request.level = level_.toStdString();
+        srv.request.logger = loggers_[i].toStdString();
+        ROS_DEBUG("Setting log level for %s/%s to %s", node_.toStdString().c_str(),
+                  srv.request.logger.c_str(), srv.request.level.c_str());
+        if (!LoggerService::callService(client, srv)) {
+          ROS_WARN("Service call to %s failed.", service_name.c_str());
+          success = false;
+          error = "Failed to set logger level.";
+        }
+      }
+    }
+
+    QMetaObject::invokeMethod(service_, "handleLevelSet", Qt::QueuedConnection,
+                              Q_ARG(QString, node_),
+                              Q_ARG(QString, level_),
+                              Q_ARG(bool, success),
+                              Q_ARG(QString, error));
+  }
+
+ private:
+  LoggerService *service_;
+  QString node_;
+  QStringList loggers_;
+  QString level_;
+};
+class SetMatchingLoggersTask : public QRunnable
+{
+ public:
+  SetMatchingLoggersTask(LoggerService *service,
+                         int request_id,
+                         const QString &node,
+                         const QString &pattern,
+                         const QString &level) :
+    service_(service),
+    request_id_(request_id),
+    node_(node),
+    pattern_(pattern),
+    level_(level)
+  {
+  }
+
+  void run()
+  {
+    bool success = false;
+    int logger_count = 0;
+    QString error;
+
+    std::string get_name = node_.toStdString() + GET_LOGGERS_SVC;
+    std::string set_name = node_.toStdString() + SET_LOGGER_LEVEL_SVC;
+    ros::NodeHandle nh;
+    ros::ServiceClient get_client = nh.serviceClient<roscpp::GetLoggers>(get_name);
+    ros::ServiceClient set_client = nh.serviceClient<roscpp::SetLoggerLevel>(set_name);
+    roscpp::GetLoggers get_srv;
+
+    if (!get_client.waitForExistence(ros::Duration(SERVICE_WAIT_SECS))) {
+      ROS_WARN("Timed out while waiting for service at %s.", get_name.c_str());
+      error = "Timed out waiting for get_loggers service.";
+    } else if (!LoggerService::callService(get_client, get_srv)) {
+      ROS_WARN("Service call to %s failed.", get_name.c_str());
+      error = "Service call to get_loggers failed.";
+    } else {
+      success = true;
+      QRegExp matcher(pattern_, Qt::CaseSensitive, QRegExp::Wildcard);
+      for (size_t i = 0; i < get_srv.response.loggers.size(); i++) {
+        const std::string &logger = get_srv.response.loggers[i].name;
+        if (!matcher.exactMatch(QString::fromStdString(logger))) {
+          continue;
+        }
+
+        roscpp::SetLoggerLevel set_srv;
+        set_srv.request.level = level_.toStdString();
+        set_srv.request.logger = logger;
+        if (LoggerService::callService(set_client, set_srv)) {
+          logger_count++;
+        } else {
+          ROS_WARN("Service call to %s failed.", set_name.c_str());
+          success = false;
+          error = "Failed to set logger level.";
+        }
+      }
+    }
+
+    QMetaObject::invokeMethod(service_, "handleMatchingLevelSet", Qt::QueuedConnection,
+                              Q_ARG(int, request_id_),
+                              Q_ARG(QString, node_),
+                              Q_ARG(QString, level_),
+                              Q_ARG(int, logger_count),
+                              Q_ARG(bool, success),
+                              Q_ARG(QString, error));
+  }
+
+ private:
+  LoggerService *service_;
+  int request_id_;
+  QString node_;
+  QString pattern_;
+  QString level_;
+};
+}  // namespace
+
+LoggerService::LoggerService(QObject *parent) :
+  QObject(parent),
+  last_request_id_(0)
+{
+  pool_.setMaxThreadCount(MAX_CONCURRENT_CALLS);
+  prefetch_pool_.setMaxThreadCount(1);
+}
+
+LoggerService::~LoggerService()
+{
+  // Drop calls that haven't started and wait for the running ones; their
+  // queued results are discarded along with this object.
+  cancelPrefetch();
+  pool_.clear();
+  pool_.waitForDone();
+  prefetch_pool_.waitForDone();
+}
+
+bool LoggerService::cachedLoggers(const QString &node,
+                                  QStringList *names,
+                                  QStringList *levels) const
+{
+  std::map<QString, CacheEntry>::const_iterator it = cache_.find(node);
+  if (it == cache_.end() || it->second.age.hasExpired(LOGGER_CACHE_TTL_MS)) {
+    return false;
+  }
+
+  *names = it->second.names;
+  *levels = it->second.levels;
+  return true;
+}
+
+void LoggerService::fetchLoggers(const QString &node)
+{
+  QStringList names;
+  QStringList levels;
+  if (cachedLoggers(node, &names, &levels) || pending_fetches_.count(node)) {
+    return;
+  }
+
+  // The user is waiting on this node now, so a prefetch of it would
+  // only duplicate the call.
+  if (node == prefetch_node_) {
+    cancelPrefetch();
+  }
+
+  pending_fetches_.insert(node);
+  pool_.start(new GetLoggersTask(this, node));
+}
+
+void LoggerService::prefetchLoggers(const QString &node)
+{
+  QStringList names;
+  QStringList levels;
+  if (node == prefetch_node_ ||
+      cachedLoggers(node, &names, &levels) ||
+      pending_fetches_.count(node)) {
+    return;
+  }
+
+  cancelPrefetch();
+  prefetch_node_ = node;
+  prefetch_token_ = CancelToken();
+  prefetch_pool_.start(new GetLoggersTask(this, node, true, prefetch_token_));
+}
+
+void LoggerService::cancelPrefetch()
+{
+  prefetch_token_.cancel();
+  prefetch_node_.clear();
+  prefetch_pool_.clear();
+}
+
+void LoggerService::setLoggerLevel(const QString &node,
+                                   const QStringList &loggers,
+                                   const QString &level)
+{
+  pool_.start(new SetLoggerLevelTask(this, node, loggers, level));
+}
+
+void LoggerService::setMatchingLoggerLevel(int request_id,
+                                           const QString &node,
+                                           const QString &pattern,
+                                           const QString &level)
+{
+  pool_.start(new SetMatchingLoggersTask(this, request_id, node, pattern, level));
+}
+
+void LoggerService::handleLoggers(const QString &node,
+                                  const QStringList &names,
+                                  const QStringList &levels,
+                                  bool success,
+                                  const QString &error,
+                                  bool prefetch)
+{
+  if (prefetch) {
+    if (node == prefetch_node_) {
+      prefetch_node_.clear();
+    }
+  } else {
+    pending_fetches_.erase(node);
+  }
+
+  if (!success) {
+    // Nobody is waiting on a prefetch, and a menu opened for the node
+    // makes its own call.
+    if (!prefetch) {
+      Q_EMIT loggersFailed(node, error);
+    }
+    return;
+  }
+
+  CacheEntry &entry = cache_[node];
+  entry.names = names;
+  entry.levels = levels;
+  entry.age.start();
+  Q_EMIT loggersReceived(node, names, levels);
+}
+
+void LoggerService::handleLevelSet(const QString &node,
+                                   const QString &level,
+                                   bool success,
+                                   const QString &error)
+{
+  // The cached levels are stale now, so the next menu for this node
+  // fetches a fresh list.
+  cache_.erase(node);
+  Q_EMIT loggerLevelSet(node, level, success, error);
+}
+
+void LoggerService::handleMatchingLevelSet(int request_id,
+                                           const QString &node,
+                                           const QString &level,
+                                           int logger_count,
+                                           bool success,
+                                           const QString &error)
+{
+  cache_.erase(node);
+  Q_EMIT matchingLevelSet(request_id, node, level, logger_count, success, error);
+}
+}  // namespace swri_console
@@ -29,20 +29,46 @@
 // *****************************************************************************
 
 #include <swri_console/node_click_handler.h>
+#include <swri_console/logger_level_dialog.h>
+#include <swri_console/logger_service.h>
 #include <swri_console/node_list_model.h>
 
 #include <ros/ros.h>
-#include <roscpp/GetLoggers.h>
-#include <roscpp/SetLoggerLevel.h>
 
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QTextStream>
 
 namespace swri_console
 {
   const std::string NodeClickHandler::ALL_LOGGERS = "All Loggers";
-  const std::string NodeClickHandler::GET_LOGGERS_SVC = "/get_loggers";
-  const std::string NodeClickHandler::SET_LOGGER_LEVEL_SVC = "/set_logger_level";
+
+  NodeClickHandler::NodeClickHandler(QObject* parent) :
+    QObject(parent),
+    logger_service_(new LoggerService(this)),
+    bulk_pattern_("ros.*")
+  {
+    QObject::connect(
+      logger_service_, SIGNAL(loggersReceived(const QString&, const QStringList&, const QStringList&)),
+      this, SLOT(handleLoggersReceived(const QString&, const QStringList&, const QStringList&)));
+    QObject::connect(
+      logger_service_, SIGNAL(loggersFailed(const QString&, const QString&)),
+      this, SLOT(handleLoggersFailed(const QString&, const QString&)));
+    QObject::connect(
+      logger_service_, SIGNAL(loggerLevelSet(const QString&, const QString&, bool, const QString&)),
+      this, SLOT(handleLoggerLevelSet(const QString&, const QString&, bool, const QString&)));
+  }
+
+  void NodeClickHandler::prefetchLoggers(const std::vector<std::string>& nodes)
+  {
+    // Only the single-node menu shows logger lists, so there is nothing
+    // to prefetch for a multiple selection.
+    if (nodes.size() == 1) {
+      logger_service_->prefetchLoggers(QString::fromStdString(nodes.front()));
+    } else {
+      logger_service_->cancelPrefetch();
+    }
+  }
 
   bool NodeClickHandler::eventFilter(QObject* obj, QEvent* event)
   {
@@ -73,55 +99,102 @@ namespace swri_console
       return false;
     }
 
-    // Now get the node name that was clicked on and make a service call to
-    // get all of the loggers registered for that node.
+    if (index_list.size() > 1) {
+      showBulkMenu(list, event);
+      return false;
+    }
+
+    // Now get the node name that was clicked on.  The menu opens right away;
+    // if the node's loggers aren't cached yet, they are fetched in the
+    // background and added to the menu when they arrive.
     NodeListModel* model = static_cast<NodeListModel*>(list->model());
     node_name_ = model->nodeName(index_list.first());
+    QString node = QString::fromStdString(node_name_);
 
-    std::string service_name = node_name_ + GET_LOGGERS_SVC;
-    ros::ServiceClient client = nh_.serviceClient<roscpp::GetLoggers>(service_name);
-    /**
-     * Normally this call should return very quickly, but we don't want the GUI to
-     * hang if the roscore is stuck, so add a timeout.
-     * The value is pretty arbitrary, but we also want to give enough time for this
-     * to still respond over a slow network link, so it shouldn't be *too* small.
-     */
-    if (!client.waitForExistence(ros::Duration(2.0))) {
-      ROS_WARN("Timed out while waiting for service at %s.", service_name.c_str());
-      QMessageBox::warning(list, "Error Getting Loggers", "Timed out waiting for get_loggers service.");
-      return false;
+    if (menu_) {
+      menu_->hide();
+    }
+    menu_ = new QMenu(list);
+    loading_action_ = NULL;
+    QObject::connect(menu_, SIGNAL(aboutToHide()), menu_, SLOT(deleteLater()));
+    QAction* label = menu_->addAction(node + " loggers:");
+    label->setDisabled(true);
+
+    QStringList names;
+    QStringList levels;
+    if (logger_service_->cachedLoggers(node, &names, &levels)) {
+      populateMenu(names, levels);
+    }
+    else {
+      loading_action_ = menu_->addAction("Loading...");
+      loading_action_->setDisabled(true);
+      logger_service_->fetchLoggers(node);
     }
 
-    roscpp::GetLoggers srv;
+    menu_->popup(event->globalPos());
+
+    return false;
+  }
+
+  void NodeClickHandler::showBulkMenu(QListView* list, QContextMenuEvent* event)
+  {
+    NodeListModel* model = static_cast<NodeListModel*>(list->model());
+    QModelIndexList index_list = list->selectionModel()->selectedIndexes();
+    bulk_nodes_.clear();
+    for (int i = 0; i < index_list.size(); i++) {
+      bulk_nodes_.append(QString::fromStdString(model->nodeName(index_list[i])));
+    }
 
-    QMenu menu(list);
-    QAction* label = menu.addAction(QString::fromStdString(node_name_ + " loggers:"));
+    if (menu_) {
+      menu_->hide();
+    }
+    menu_ = new QMenu(list);
+    QObject::connect(menu_, SIGNAL(aboutToHide()), menu_, SLOT(deleteLater()));
+    QAction* label = menu_->addAction(QString("%1 selected nodes:").arg(bulk_nodes_.size()));
     label->setDisabled(true);
 
-    ROS_DEBUG("Getting loggers for %s...", node_name_.c_str());
-    if (callService(client, srv)) {
-      all_loggers_.clear();
-      menu.addMenu(createMenu(QString::fromStdString(ALL_LOGGERS), ""));
-      Q_FOREACH(const roscpp::Logger& logger, srv.response.loggers) {
-        ROS_DEBUG("Log level for %s is %s", logger.name.c_str(), logger.level.c_str());
-        all_loggers_.push_back(logger.name);
-        QString logger_name = QString::fromStdString(logger.name);
+    QMenu* level_menu = menu_->addMenu("Set Logger Level");
+    const QString levels[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+    for (int i = 0; i < 5; i++) {
+      level_menu->addAction(levels[i] + "...", this, SLOT(bulkLogLevelClicked()))->setData(levels[i]);
+    }
+
+    menu_->popup(event->globalPos());
+  }
 
-        menu.addMenu(createMenu(logger_name, QString::fromStdString(logger.level)));
-      }
+  void NodeClickHandler::populateMenu(const QStringList& names, const QStringList& levels)
+  {
+    if (loading_action_) {
+      menu_->removeAction(loading_action_);
+      delete loading_action_;
     }
-    else {
-      std::string error = "Service call to get_loggers failed.";
-      ROS_WARN("%s", error.c_str());
-      QMessageBox::warning(list, "Service Call Failed", error.c_str());
+
+    all_loggers_ = names;
+    menu_->addMenu(createMenu(menu_, QString::fromStdString(ALL_LOGGERS), ""));
+    for (int i = 0; i < names.size(); i++) {
+      menu_->addMenu(createMenu(menu_, names[i], levels[i]));
     }
+  }
 
-    menu.exec(event->globalPos());
+  void NodeClickHandler::handleLoggersReceived(const QString& node,
+                                               const QStringList& names,
+                                               const QStringList& levels)
+  {
+    // A prefetch and the menu's own fetch may both deliver the list;
+    // only the first one fills the menu.
+    if (menu_ && loading_action_ && node.toStdString() == node_name_) {
+      populateMenu(names, levels);
+    }
+  }
 
-    return false;
+  void NodeClickHandler::handleLoggersFailed(const QString& node, const QString& error)
+  {
+    if (menu_ && loading_action_ && node.toStdString() == node_name_) {
+      loading_action_->setText(error);
+    }
   }
 
-  QMenu* NodeClickHandler::createMenu(const QString& logger_name, const QString& current_level)
+  QMenu* NodeClickHandler::createMenu(QMenu* parent, const QString& logger_name, const QString& current_level)
   {
     QString action_label;
     QTextStream stream(&action_label);
@@ -130,7 +203,7 @@ namespace swri_console
       stream << " (" << current_level.toUpper() << ")";
     }
 
-    QMenu* nodeMenu = new QMenu(action_label);
+    QMenu* nodeMenu = new QMenu(action_label, parent);
 
     const QString levels[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
 
@@ -146,39 +219,52 @@ namespace swri_console
   {
     QAction* action = static_cast<QAction*>(sender());
 
-    std::string logger = action->data().toString().toStdString();
-    std::string level = action->text().toStdString();
-    ROS_DEBUG("Setting log level for %s/%s to %s", node_name_.c_str(), logger.c_str(), level.c_str());
+    QString logger = action->data().toString();
+    QString level = action->text();
+
+    QStringList target_loggers;
+    if (logger.toStdString() == ALL_LOGGERS) {
+      target_loggers = all_loggers_;
+    }
+    else {
+      target_loggers.append(logger);
+    }
+
+    logger_service_->setLoggerLevel(QString::fromStdString(node_name_), target_loggers, level);
+  }
 
-    std::string service_name = node_name_ + SET_LOGGER_LEVEL_SVC;
+  void NodeClickHandler::bulkLogLevelClicked()
+  {
+    QAction* action = static_cast<QAction*>(sender());
+    QString level = action->data().toString();
 
-    ros::ServiceClient client = nh_.serviceClient<roscpp::SetLoggerLevel>(service_name);
-    if (!client.waitForExistence(ros::Duration(2.0))) {
-      ROS_WARN("Timed out while waiting for service at %s.", service_name.c_str());
-      QMessageBox::warning(NULL, "Error Getting Loggers", "Timed out waiting for set_logger_level service.");
+    bool ok = false;
+    QString pattern = QInputDialog::getText(
+      NULL,
+      "Set Logger Level",
+      QString("Loggers to set to %1 on %2 nodes (wildcards allowed):").arg(level).arg(bulk_nodes_.size()),
+      QLineEdit::Normal,
+      bulk_pattern_,
+      &ok);
+    if (!ok || pattern.isEmpty()) {
       return;
     }
+    bulk_pattern_ = pattern;
 
-    std::vector<std::string> target_loggers;
-    if (logger == ALL_LOGGERS) {
-      target_loggers = all_loggers_;
+    LoggerLevelDialog* dialog = new LoggerLevelDialog(logger_service_, bulk_nodes_, pattern, level);
+    dialog->show();
+  }
+
+  void NodeClickHandler::handleLoggerLevelSet(const QString& node,
+                                              const QString& level,
+                                              bool success,
+                                              const QString& error)
+  {
+    if (success) {
+      ROS_DEBUG("Set logger level for %s to %s.", node.toStdString().c_str(), level.toStdString().c_str());
     }
     else {
-      target_loggers.push_back(logger);
-    }
-
-    Q_FOREACH (const std::string& logger_name, target_loggers) {
-      roscpp::SetLoggerLevel srv;
-      srv.request.level = level;
-      srv.request.logger = logger_name;
-      if (callService(client, srv)) {
-        ROS_DEBUG("Set logger level.");
-      }
-      else {
-        ROS_WARN("Service call to %s failed.", service_name.c_str());
-        QMessageBox::warning(NULL, "Error Setting Log Level", "Failed to set logger level.");
-      }
+      QMessageBox::warning(NULL, "Error Setting Log Level", error);
     }
   }
 }
-
@@ -28,7 +28,7 @@
 //
 // *****************************************************************************
 
-#include <stdio.h>
+#include <algorithm>
 #include <vector>
 
 #include <swri_console/node_list_model.h>
@@ -36,14 +36,40 @@
 
 namespace swri_console
 {
+// How often the decayed rates are redrawn and, when sorting by rate,
+// the nodes reordered, in milliseconds.  Reordering on every batch
+// would make the list impossible to click on during a log storm.
+static const int REFRESH_INTERVAL_MS = 1000;
+
+// Orders rows by name, or by descending rate and then name.
+struct NodeListModel::RowOrder
+{
+  bool by_rate;
+
+  explicit RowOrder(bool sort_by_rate) : by_rate(sort_by_rate) {}
+
+  bool operator()(const Row &a, const Row &b) const
+  {
+    if (by_rate && a.rate != b.rate) {
+      return a.rate > b.rate;
+    }
+    return a.name < b.name;
+  }
+};
+
 NodeListModel::NodeListModel(LogDatabase *db)
   :
-  db_(db)
+  db_(db),
+  sort_by_rate_(false)
 {
   QObject::connect(db_, SIGNAL(databaseCleared()),
                    this, SLOT(handleDatabaseCleared()));
   QObject::connect(db_, SIGNAL(messagesAdded()),
                    this, SLOT(handleMessagesAdded()));
+
+  QObject::connect(&sort_timer_, SIGNAL(timeout()),
+                   this, SLOT(refreshRows()));
+  sort_timer_.start(REFRESH_INTERVAL_MS);
 }
 
 NodeListModel::~NodeListModel()
@@ -58,28 +84,52 @@ int NodeListModel::rowCount(const QModelIndex &parent) const
 std::string NodeListModel::nodeName(const QModelIndex &index) const
 {
   if (index.parent().isValid() ||
-      static_cast<size_t>(index.row()) > ordering_.size()) {
+      static_cast<size_t>(index.row()) >= ordering_.size()) {
     return "";
   }
 
-  return ordering_[index.row()];
+  return ordering_[index.row()].name;
 }
 
 QVariant NodeListModel::data(const QModelIndex &index, int role) const
 {
   if (index.parent().isValid() ||
-      static_cast<size_t>(index.row()) > ordering_.size()) {
+      static_cast<size_t>(index.row()) >= ordering_.size()) {
     return QVariant();
   } 
 
-  std::string name = ordering_[index.row()];
-  
+  const Row &row = ordering_[index.row()];
+  QString name = QString::fromStdString(row.name);
+
+  // Nodes stay listed when the database is cleared, so they may not
+  // have any statistics.
+  NodeStats stats;
+  if (row.node_id < db_->nodeStats().size()) {
+    stats = db_->nodeStats()[row.node_id];
+  }
+
   if (role == Qt::DisplayRole) {
-    char buffer[1023];
-    snprintf(buffer, sizeof(buffer), "%s (%lu)",
-             name.c_str(),
-             data_.find(name)->second);
-    return QVariant(QString(buffer));
+    return QVariant(QString("%1 (%2, %3/s)")
+                    .arg(name)
+                    .arg(stats.count())
+                    .arg(db_->nodeRate(row.node_id), 0, 'f', 1));
+  } else if (role == Qt::ToolTipRole) {
+    QString tip = QString("%1\n"
+                          "Debug: %2\n"
+                          "Info: %3\n"
+                          "Warn: %4\n"
+                          "Error: %5\n"
+                          "Fatal: %6")
+      .arg(name)
+      .arg(stats.levelCount(rosgraph_msgs::Log::DEBUG))
+      .arg(stats.levelCount(rosgraph_msgs::Log::INFO))
+      .arg(stats.levelCount(rosgraph_msgs::Log::WARN))
+      .arg(stats.levelCount(rosgraph_msgs::Log::ERROR))
+      .arg(stats.levelCount(rosgraph_msgs::Log::FATAL));
+    if (stats.count() > 0) {
+      tip += QString("\nLast message: %1").arg(stats.lastSeen().toSec(), 0, 'f', 3);
+    }
+    return QVariant(tip);
   }
 
   return QVariant();
@@ -91,47 +141,182 @@ void NodeListModel::clear()
     return;
   }
   beginRemoveRows(QModelIndex(), 0, ordering_.size()-1);
-  data_.clear();
   ordering_.clear();
+  rows_.clear();
   endRemoveRows();
 }
 
+void NodeListModel::setSortByRate(bool sort_by_rate)
+{
+  if (sort_by_rate == sort_by_rate_) {
+    return;
+  }
+  sort_by_rate_ = sort_by_rate;
+  int first;
+  int last;
+  updateRates(&first, &last);
+  if (!sortRows() && first >= 0) {
+    Q_EMIT dataChanged(index(first), index(last));
+  }
+}
+
 void NodeListModel::handleDatabaseCleared()
 {
   // When the database is cleared, we reset all of the counts to zero
   // instead of deleting them from the list.  This allows a user to
   // clear out the logs while retaining their node selection so that
   // they can easily reset the data without having to choose the
-  // selection again.  
-  std::map<std::string, size_t>::iterator iter;
-  for (iter = data_.begin(); iter != data_.end(); ++iter) {
-    (*iter).second = 0;
+  // selection again.  The database has already dropped the
+  // statistics and reassigned the node IDs, so the rows are matched
+  // up by name again as the nodes log.
+  rows_.clear();
+  for (size_t i = 0; i < ordering_.size(); i++) {
+    ordering_[i].node_id = NO_NODE;
   }
-
-  Q_EMIT dataChanged(index(0), index(data_.size()-1));
+  if (ordering_.empty()) {
+    return;
+  }
+  Q_EMIT dataChanged(index(0), index(ordering_.size()-1));
 }
 
 void NodeListModel::handleMessagesAdded()
 {
-  const std::map<std::string, size_t> &msg_counts = db_->messageCounts();
-  
-  size_t i = 0;
-  for (std::map<std::string, size_t>::const_iterator it = msg_counts.begin();
-       it != msg_counts.end();
-       ++it)
-  {
-    if (!data_.count(it->first)) {
-      beginInsertRows(QModelIndex(), i, i);
-      data_[it->first] = it->second;
-      ordering_.insert(ordering_.begin() + i, it->first);
-      endInsertRows();
+  // Only the nodes in the latest batch have new counts; the rest are
+  // redrawn by refreshRows() as their rates decay.
+  const std::vector<uint32_t> &changed = db_->changedNodes();
+  for (size_t i = 0; i < changed.size(); i++) {
+    uint32_t node_id = changed[i];
+    if (node_id >= rows_.size() || rows_[node_id] < 0) {
+      addNode(node_id);
     } else {
-      data_[it->first] = it->second;
+      QModelIndex row = index(rows_[node_id]);
+      Q_EMIT dataChanged(row, row);
     }
-    i++;
   }
-  
-  Q_EMIT dataChanged(index(0),
-                     index(ordering_.size()-1));
+}
+
+void NodeListModel::addNode(uint32_t node_id)
+{
+  if (node_id >= rows_.size()) {
+    rows_.resize(node_id + 1, -1);
+  }
+
+  // A node that was listed before the database was cleared keeps its
+  // row.
+  const std::string &name = db_->nodes().value(node_id);
+  for (size_t i = 0; i < ordering_.size(); i++) {
+    if (ordering_[i].node_id == NO_NODE && ordering_[i].name == name) {
+      ordering_[i].node_id = node_id;
+      rows_[node_id] = i;
+      QModelIndex row = index(i);
+      Q_EMIT dataChanged(row, row);
+      return;
+    }
+  }
+
+  insertNode(node_id);
+}
+
+void NodeListModel::insertNode(uint32_t node_id)
+{
+  Row new_row;
+  new_row.name = db_->nodes().value(node_id);
+  new_row.node_id = node_id;
+  new_row.rate = 0.0;
+
+  // New nodes go in name order.  When sorting by rate, they are added
+  // at the end until the next refreshRows().
+  size_t row = ordering_.size();
+  if (!sort_by_rate_) {
+    row = std::lower_bound(ordering_.begin(), ordering_.end(), new_row,
+                           RowOrder(false)) - ordering_.begin();
+  }
+
+  beginInsertRows(QModelIndex(), row, row);
+  ordering_.insert(ordering_.begin() + row, new_row);
+  for (size_t i = row; i < ordering_.size(); i++) {
+    if (ordering_[i].node_id != NO_NODE) {
+      rows_[ordering_[i].node_id] = i;
+    }
+  }
+  endInsertRows();
+}
+
+void NodeListModel::refreshRows()
+{
+  int first;
+  int last;
+  updateRates(&first, &last);
+
+  // Layout changes redraw every row, so the rates don't need to be
+  // redrawn separately if the rows were reordered.
+  if (sort_by_rate_ && sortRows()) {
+    return;
+  }
+  if (first >= 0) {
+    Q_EMIT dataChanged(index(first), index(last));
+  }
+}
+
+void NodeListModel::updateRates(int *first, int *last)
+{
+  *first = -1;
+  *last = -1;
+  for (size_t i = 0; i < ordering_.size(); i++) {
+    // Rows of nodes that haven't logged since a clear have no ID, which
+    // nodeRate() reports as 0.
+    double rate = db_->nodeRate(ordering_[i].node_id);
+    // Rates are shown with one decimal place.
+    if (qRound(rate * 10.0) != qRound(ordering_[i].rate * 10.0)) {
+      if (*first < 0) {
+        *first = i;
+      }
+      *last = i;
+    }
+    ordering_[i].rate = rate;
+  }
+}
+
+bool NodeListModel::sortRows()
+{
+  RowOrder order(sort_by_rate_);
+  bool sorted = true;
+  for (size_t i = 1; i < ordering_.size() && sorted; i++) {
+    sorted = !order(ordering_[i], ordering_[i-1]);
+  }
+  if (sorted) {
+    return false;
+  }
+
+  Q_EMIT layoutAboutToBeChanged();
+
+  // Remember which node each persistent index (such as the selection)
+  // refers to so that it follows the node to its new row.
+  QModelIndexList old_indexes = persistentIndexList();
+  std::vector<std::string> old_nodes;
+  for (int i = 0; i < old_indexes.size(); i++) {
+    old_nodes.push_back(ordering_[old_indexes[i].row()].name);
+  }
+
+  // Stable so that nodes with equal rates and names don't swap places.
+  std::stable_sort(ordering_.begin(), ordering_.end(), order);
+  for (size_t i = 0; i < ordering_.size(); i++) {
+    if (ordering_[i].node_id != NO_NODE) {
+      rows_[ordering_[i].node_id] = i;
+    }
+  }
+
+  QModelIndexList new_indexes;
+  for (size_t i = 0; i < old_nodes.size(); i++) {
+    size_t row = 0;
+    while (ordering_[row].name != old_nodes[i]) {
+      row++;
+    }
+    new_indexes.append(index(row));
+  }
+  changePersistentIndexList(old_indexes, new_indexes);
+
+  Q_EMIT layoutChanged();
+  return true;
 }
 }  // namespace swri_console
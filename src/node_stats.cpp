@@ -0,0 +1,117 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/node_stats.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <swri_console/log_database.h>
+
+namespace swri_console
+{
+// Time constant of the moving average, in seconds.  Short enough that a
+// node that starts flooding rises to the top of the list within a few
+// seconds, long enough that the list doesn't reorder on every burst.
+static const double RATE_TIME_CONSTANT = 5.0;
+
+// Returns the index of a severity level in NodeStats::level_counts_, or
+// -1 if it isn't one of the rosgraph_msgs::Log levels.
+static int levelIndex(uint8_t level)
+{
+  switch (level) {
+    case rosgraph_msgs::Log::DEBUG: return 0;
+    case rosgraph_msgs::Log::INFO: return 1;
+    case rosgraph_msgs::Log::WARN: return 2;
+    case rosgraph_msgs::Log::ERROR: return 3;
+    case rosgraph_msgs::Log::FATAL: return 4;
+    default: return -1;
+  }
+}
+
+NodeStats::NodeStats()
+  :
+  count_(0),
+  pending_(0),
+  rate_(0.0),
+  live_(false)
+{
+  std::fill(level_counts_, level_counts_ + 5, 0);
+}
+
+void NodeStats::add(const LogEntry &entry)
+{
+  count_++;
+  int index = levelIndex(entry.level);
+  if (index >= 0) {
+    level_counts_[index]++;
+  }
+  pending_++;
+  if (entry.stamp > last_seen_) {
+    last_seen_ = entry.stamp;
+  }
+}
+
+void NodeStats::addSuppressed(size_t count, const ros::Time &stamp)
+{
+  pending_ += count;
+  if (stamp > last_seen_) {
+    last_seen_ = stamp;
+  }
+}
+
+size_t NodeStats::levelCount(uint8_t level) const
+{
+  int index = levelIndex(level);
+  return index < 0 ? 0 : level_counts_[index];
+}
+
+void NodeStats::updateRate()
+{
+  if (pending_ == 0) {
+    return;
+  }
+
+  // Each message contributes exp(-age / T) / T, which averages to the
+  // message rate over roughly the last T seconds.  Decaying the sum from
+  // the previous update is enough to age every earlier message at once.
+  rate_ = rate(last_seen_) + pending_ / RATE_TIME_CONSTANT;
+  rate_stamp_ = std::max(rate_stamp_, last_seen_);
+  pending_ = 0;
+}
+
+double NodeStats::rate(const ros::Time &now) const
+{
+  if (now <= rate_stamp_) {
+    return rate_;
+  }
+  return rate_ * std::exp(-(now - rate_stamp_).toSec() / RATE_TIME_CONSTANT);
+}
+}  // namespace swri_console
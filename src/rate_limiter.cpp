@@ -0,0 +1,200 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/rate_limiter.h>
+
+#include <algorithm>
+
+#include <rosgraph_msgs/Log.h>
+
+namespace swri_console
+{
+// Minimum time between two summaries of the same bucket, in seconds.
+static const double SUMMARY_INTERVAL = 1.0;
+
+RateLimiter::RateLimiter()
+{
+}
+
+void RateLimiter::setNodeLimit(double rate, double burst)
+{
+  node_limit_.rate = rate;
+  node_limit_.burst = std::max(1.0, burst);
+}
+
+void RateLimiter::setLocationLimit(double rate, double burst)
+{
+  location_limit_.rate = rate;
+  location_limit_.burst = std::max(1.0, burst);
+}
+
+bool RateLimiter::accept(uint32_t node_id,
+                         uint32_t file_id,
+                         uint32_t line,
+                         uint8_t level,
+                         const ros::Time &stamp)
+{
+  if (stamp > latest_) {
+    latest_ = stamp;
+  }
+
+  // Warnings and errors are exactly what a user is looking for in a
+  // flood, so they always get through.
+  if (level >= rosgraph_msgs::Log::WARN) {
+    return true;
+  }
+
+  Bucket *location = NULL;
+  if (location_limit_.enabled()) {
+    uint64_t key = locationKey(file_id, line);
+    location = &location_buckets_[key];
+    refill(*location, location_limit_, stamp);
+    if (location->tokens < 1.0) {
+      location->suppressed.node_id = node_id;
+      location->suppressed.by_location = true;
+      location->suppressed.file_id = file_id;
+      location->suppressed.line = line;
+      suppress(*location, level, stamp);
+      pending_locations_.insert(key);
+      return false;
+    }
+  }
+
+  Bucket *node = NULL;
+  if (node_limit_.enabled()) {
+    if (node_id >= node_buckets_.size()) {
+      node_buckets_.resize(node_id + 1);
+    }
+    node = &node_buckets_[node_id];
+    refill(*node, node_limit_, stamp);
+    if (node->tokens < 1.0) {
+      node->suppressed.node_id = node_id;
+      suppress(*node, level, stamp);
+      pending_nodes_.insert(node_id);
+      return false;
+    }
+  }
+
+  // Only take tokens once both limits have accepted the message, so a
+  // message rejected by its node doesn't use up its location's budget.
+  if (location) {
+    location->tokens -= 1.0;
+  }
+  if (node) {
+    node->tokens -= 1.0;
+  }
+  return true;
+}
+
+void RateLimiter::advanceTo(const ros::Time &now)
+{
+  if (now > latest_) {
+    latest_ = now;
+  }
+}
+
+void RateLimiter::takeSummaries(bool force, std::vector<Suppression> *summaries)
+{
+  std::set<uint32_t>::iterator node_it = pending_nodes_.begin();
+  while (node_it != pending_nodes_.end()) {
+    if (takeSummary(node_buckets_[*node_it], force, summaries)) {
+      pending_nodes_.erase(node_it++);
+    } else {
+      ++node_it;
+    }
+  }
+
+  std::set<uint64_t>::iterator location_it = pending_locations_.begin();
+  while (location_it != pending_locations_.end()) {
+    if (takeSummary(location_buckets_[*location_it], force, summaries)) {
+      pending_locations_.erase(location_it++);
+    } else {
+      ++location_it;
+    }
+  }
+}
+
+void RateLimiter::clear()
+{
+  node_buckets_.clear();
+  location_buckets_.clear();
+  pending_nodes_.clear();
+  pending_locations_.clear();
+  latest_ = ros::Time();
+}
+
+void RateLimiter::refill(Bucket &bucket, const Limit &limit, const ros::Time &stamp)
+{
+  if (!bucket.started) {
+    bucket.started = true;
+    bucket.tokens = limit.burst;
+    bucket.last_refill = stamp;
+    bucket.last_summary = stamp;
+    return;
+  }
+
+  // Stamps from different publishers aren't strictly ordered, so the
+  // bucket only refills when time moves forward.  A stamp that is
+  // further back than it takes to refill the whole bucket comes from
+  // a different timeline (another bag file, or a restarted sim clock).
+  // Without a restart, the bucket would stay empty until the new
+  // stamps caught up with the old ones.
+  const double window = limit.burst / limit.rate;
+  if (stamp < bucket.last_refill &&
+      (bucket.last_refill - stamp).toSec() > window) {
+    bucket.tokens = limit.burst;
+    bucket.last_refill = stamp;
+  } else if (stamp > bucket.last_refill) {
+    double elapsed = (stamp - bucket.last_refill).toSec();
+    bucket.tokens = std::min(limit.burst, bucket.tokens + elapsed * limit.rate);
+    bucket.last_refill = stamp;
+  }
+}
+
+void RateLimiter::suppress(Bucket &bucket, uint8_t level, const ros::Time &stamp)
+{
+  bucket.suppressed.count++;
+  bucket.suppressed.level = std::max(bucket.suppressed.level, level);
+  bucket.suppressed.stamp = stamp;
+}
+
+bool RateLimiter::takeSummary(Bucket &bucket, bool force, std::vector<Suppression> *summaries)
+{
+  if (!force && (latest_ - bucket.last_summary).toSec() < SUMMARY_INTERVAL) {
+    return false;
+  }
+
+  summaries->push_back(bucket.suppressed);
+  bucket.suppressed.count = 0;
+  bucket.suppressed.level = 0;
+  bucket.last_summary = latest_;
+  return true;
+}
+}  // namespace swri_console
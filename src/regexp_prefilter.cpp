@@ -0,0 +1,280 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/regexp_prefilter.h>
+
+#include <ctype.h>
+#include <algorithm>
+
+namespace swri_console
+{
+// Returns the index just past the character class that starts at pos,
+// or -1 if the class isn't terminated.
+static int skipClass(const QString &pattern, int pos)
+{
+  int i = pos + 1;
+  if (i < pattern.size() && pattern[i] == '^') {
+    i++;
+  }
+  // A ']' at the start of a class is a literal.
+  if (i < pattern.size() && pattern[i] == ']') {
+    i++;
+  }
+  while (i < pattern.size() && pattern[i] != ']') {
+    if (pattern[i] == '\\') {
+      i++;
+    }
+    i++;
+  }
+  return i < pattern.size() ? i + 1 : -1;
+}
+
+// Returns the index of the ')' that closes the group starting at pos,
+// or -1 if the group isn't terminated.
+static int findGroupEnd(const QString &pattern, int pos)
+{
+  int depth = 0;
+  for (int i = pos; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+    } else if (pattern[i] == '[') {
+      int end = skipClass(pattern, i);
+      if (end < 0) {
+        return -1;
+      }
+      i = end - 1;
+    } else if (pattern[i] == '(') {
+      depth++;
+    } else if (pattern[i] == ')') {
+      depth--;
+      if (depth == 0) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+// Returns true if the pattern has a '|' outside of any group or class,
+// in which case no literal is required by every match.
+static bool hasTopLevelAlternation(const QString &pattern)
+{
+  for (int i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+    } else if (pattern[i] == '[') {
+      int end = skipClass(pattern, i);
+      if (end < 0) {
+        return true;
+      }
+      i = end - 1;
+    } else if (pattern[i] == '(') {
+      int end = findGroupEnd(pattern, i);
+      if (end < 0) {
+        return true;
+      }
+      i = end;
+    } else if (pattern[i] == '|') {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Skips the quantifiers that follow an atom.  optional is set if the
+// atom may match zero times and repeated if it may match more than
+// once.  Returns the index after the quantifiers.
+static int skipQuantifiers(const QString &pattern, int pos, bool *optional, bool *repeated)
+{
+  *optional = false;
+  *repeated = false;
+  while (pos < pattern.size()) {
+    QChar c = pattern[pos];
+    if (c == '*') {
+      *optional = true;
+      *repeated = true;
+      pos++;
+    } else if (c == '+') {
+      *repeated = true;
+      pos++;
+    } else if (c == '?') {
+      *optional = true;
+      pos++;
+    } else if (c == '{') {
+      int end = pattern.indexOf('}', pos);
+      if (end < 0) {
+        break;
+      }
+      QString range = pattern.mid(pos + 1, end - pos - 1);
+      bool ok = false;
+      int min = range.section(',', 0, 0).toInt(&ok);
+      *optional = *optional || !ok || min == 0;
+      *repeated = *repeated || range.contains(',') || min != 1;
+      pos = end + 1;
+    } else {
+      break;
+    }
+  }
+  return pos;
+}
+
+static void addLiteral(QString *literal, QStringList *literals)
+{
+  if (!literal->isEmpty()) {
+    literals->append(*literal);
+    literal->clear();
+  }
+}
+
+// Appends the literals that every match of a QRegExp::RegExp pattern
+// must contain.
+static void extractLiterals(const QString &pattern, QStringList *literals)
+{
+  if (hasTopLevelAlternation(pattern)) {
+    return;
+  }
+
+  // The literal run that we're currently building.  It is ended by any
+  // atom that isn't a plain, required character.
+  QString current;
+  int i = 0;
+  while (i < pattern.size()) {
+    QChar c = pattern[i];
+    QString atom;
+    QString group;
+    int next = i + 1;
+
+    if (c == '\\') {
+      if (next >= pattern.size()) {
+        break;
+      }
+      QChar escaped = pattern[next];
+      next++;
+      if (!escaped.isLetterOrNumber()) {
+        atom = escaped;
+      } else if (escaped == 'x') {
+        while (next < pattern.size() && next < i + 6 && isxdigit(pattern[next].toLatin1())) {
+          next++;
+        }
+      } else if (escaped == '0') {
+        while (next < pattern.size() && next < i + 5 && pattern[next].unicode() >= '0' && pattern[next].unicode() <= '7') {
+          next++;
+        }
+      }
+      // Other escapes are character classes, assertions and back
+      // references, none of which are literals.
+    } else if (c == '[') {
+      next = skipClass(pattern, i);
+      if (next < 0) {
+        break;
+      }
+    } else if (c == '(') {
+      int end = findGroupEnd(pattern, i);
+      if (end < 0) {
+        break;
+      }
+      next = end + 1;
+      if (pattern.midRef(i + 1, 2) == QLatin1String("?:")) {
+        group = pattern.mid(i + 3, end - i - 3);
+      } else if (pattern.midRef(i + 1, 1) != QLatin1String("?")) {
+        group = pattern.mid(i + 1, end - i - 1);
+      }
+      // Lookahead assertions don't contribute literals.
+    } else if (QString(".^$|)*+?{").indexOf(c) < 0) {
+      atom = c;
+    }
+
+    bool optional;
+    bool repeated;
+    next = skipQuantifiers(pattern, next, &optional, &repeated);
+
+    if (!atom.isEmpty() && !optional) {
+      current += atom;
+      if (repeated) {
+        addLiteral(&current, literals);
+      }
+    } else {
+      addLiteral(&current, literals);
+      if (!group.isEmpty() && !optional) {
+        extractLiterals(group, literals);
+      }
+    }
+    i = next;
+  }
+  addLiteral(&current, literals);
+}
+
+static bool longerThan(const QString &a, const QString &b)
+{
+  return a.size() > b.size();
+}
+
+RegExpPrefilter::RegExpPrefilter()
+{
+}
+
+void RegExpPrefilter::setRegExp(const QRegExp &regexp)
+{
+  matchers_.clear();
+
+  QStringList literals;
+  if (regexp.patternSyntax() == QRegExp::RegExp ||
+      regexp.patternSyntax() == QRegExp::RegExp2) {
+    extractLiterals(regexp.pattern(), &literals);
+  } else if (regexp.patternSyntax() == QRegExp::FixedString) {
+    literals.append(regexp.pattern());
+  }
+
+  std::stable_sort(literals.begin(), literals.end(), longerThan);
+
+  QStringList kept;
+  for (int i = 0; i < literals.size(); i++) {
+    // A literal that is part of a longer one can't reject anything
+    // the longer one doesn't.
+    bool redundant = false;
+    for (int j = 0; !redundant && j < kept.size(); j++) {
+      redundant = kept[j].contains(literals[i], regexp.caseSensitivity());
+    }
+    if (!redundant && !literals[i].isEmpty()) {
+      kept.append(literals[i]);
+      matchers_.push_back(QStringMatcher(literals[i], regexp.caseSensitivity()));
+    }
+  }
+}
+
+QStringList RegExpPrefilter::literals() const
+{
+  QStringList literals;
+  for (size_t i = 0; i < matchers_.size(); i++) {
+    literals.append(matchers_[i].pattern());
+  }
+  return literals;
+}
+}  // namespace swri_console
@@ -55,6 +55,7 @@ void RosThread::run()
       stopRos();
     } else if (is_connected_ && master_status) {
       ros::spinOnce();
+      source_.flush();
       Q_EMIT spun();
     }
     msleep(50);
@@ -93,5 +94,5 @@ void RosThread::stopRos()
 
 void RosThread::handleRosout(const rosgraph_msgs::LogConstPtr &msg)
 {
-  Q_EMIT logReceived(msg);
+  source_.addMessage(msg);
 }
@@ -31,10 +31,12 @@
 #include <QFileDialog>
 #include <QDir>
 #include <QDirIterator>
+#include <QRunnable>
 
 #include <fstream>
 #include <ros/time.h>
 #include <rosbag/bag.h>
+#include <swri_console/log_database.h>
 #include <swri_console/rosout_log_loader.h>
 #include <time.h>
 #include <string>
@@ -43,23 +45,117 @@ namespace swri_console
 {
   const int MIN_MSG_SIZE=10;
 
-  void RosoutLogLoader::loadRosLogDirectory(const QString& logdirectory_name)
+  namespace
   {
+    class LoadLogTask : public QRunnable
+    {
+    public:
+      LoadLogTask(RosoutLogLoader* loader,
+                  IngestSource* source,
+                  const QString& path,
+                  bool is_directory,
+                  const CancelToken& token) :
+        loader_(loader),
+        source_(source),
+        path_(path),
+        is_directory_(is_directory),
+        token_(token)
+      {
+      }
+
+      ~LoadLogTask()
+      {
+        // The executor deletes the task even if it was cancelled before it ran, so the
+        // source is always removed.  This is queued behind the source's last batch.
+        QMetaObject::invokeMethod(loader_, "finishLoad", Qt::QueuedConnection,
+                                  Q_ARG(QObject*, source_));
+      }
+
+      void run()
+      {
+        if (is_directory_)
+        {
+          loader_->loadRosLogDirectory(source_, path_, token_);
+        }
+        else
+        {
+          loader_->loadRosLog(source_, path_, token_);
+        }
+      }
+
+    private:
+      RosoutLogLoader* loader_;
+      IngestSource* source_;
+      QString path_;
+      bool is_directory_;
+      CancelToken token_;
+    };
+  }
+
+  RosoutLogLoader::RosoutLogLoader(TaskExecutor* executor, LogDatabase* db) :
+    executor_(executor),
+    db_(db),
+    memory_budget_(0)
+  {
+  }
+
+  void RosoutLogLoader::cancel()
+  {
+    cancel_token_.cancel();
+    cancel_token_ = CancelToken();
+  }
+
+  void RosoutLogLoader::loadRosLogDirectory(IngestSource* source,
+                                            const QString& logdirectory_name,
+                                            const CancelToken& token)
+  {
+    emit source->started(logdirectory_name);
+
+    QStringList filenames;
     QDirIterator it(logdirectory_name, QStringList() << "*.log", QDir::Files);
     while (it.hasNext())
     {
-        QString filename = it.next();
-        printf("Loading log file %s ...\n", filename.toStdString().c_str());
-        loadRosLog(filename);
+      filenames.append(it.next());
+    }
+
+    for (int i = 0; i < filenames.size() && !token.isCancelled(); i++)
+    {
+        printf("Loading log file %s ...\n", filenames[i].toStdString().c_str());
+        if (!loadFile(source, filenames[i], token))
+        {
+          emit source->error(logdirectory_name, tr("Could not open %1").arg(filenames[i]));
+        }
+        emit source->progress(logdirectory_name, (i + 1) * 100 / filenames.size());
+    }
+
+    source->flush();
+    emit source->finished(logdirectory_name);
+  }
+
+  void RosoutLogLoader::loadRosLog(IngestSource* source,
+                                   const QString& logfile_name,
+                                   const CancelToken& token)
+  {
+    emit source->started(logfile_name);
+    if (!loadFile(source, logfile_name, token))
+    {
+      emit source->error(logfile_name, tr("Could not open the file"));
+      return;
     }
+    source->flush();
+    emit source->finished(logfile_name);
   }
 
-  void RosoutLogLoader::loadRosLog(const QString& logfile_name)
+  bool RosoutLogLoader::loadFile(IngestSource* source, const QString& logfile_name, const CancelToken& token)
   {
     std::string std_string_logfile = logfile_name.toStdString();
     std::ifstream logfile(std_string_logfile.c_str());
+    if (!logfile.is_open())
+    {
+      return false;
+    }
     int seq = 0;
-    for( std::string line; getline( logfile, line ); )
+    for( std::string line; !token.isCancelled() && getline( logfile, line ); )
     {
       rosgraph_msgs::Log log;
       unsigned found = std_string_logfile.find_last_of("/\\");
@@ -68,11 +164,11 @@ namespace swri_console
       if (result == 0)
       {
         rosgraph_msgs::LogConstPtr log_ptr(new rosgraph_msgs::Log(log));
-        emit logReceived(log_ptr);
+        source->addMessage(log_ptr, token);
       }
       seq++;
     }
-    emit finishedReading();
+    return true;
   }
 
   int RosoutLogLoader::parseLine(std::string line, int seq, rosgraph_msgs::Log* log)
@@ -266,7 +362,7 @@ namespace swri_console
 
     if (filename != NULL)
     {
-      loadRosLog(filename);
+      submitLoad(filename, false);
     }
   }
 
@@ -278,9 +374,27 @@ namespace swri_console
 
     if (dirname != NULL)
     {
-      loadRosLogDirectory(dirname);
+      submitLoad(dirname, true);
     }
   }
 
+  void RosoutLogLoader::submitLoad(const QString& path, bool is_directory)
+  {
+    // Each load gets its own source so that loads running at the same time don't share
+    // batches, a memory budget or rate limits.
+    IngestSource* source = new IngestSource(this);
+    source->setMemoryBudget(memory_budget_);
+    db_->addSource(source);
+    executor_->submit(new LoadLogTask(this, source, path, is_directory, cancel_token_),
+                      TaskExecutor::BULK,
+                      cancel_token_);
+  }
+
+  void RosoutLogLoader::finishLoad(QObject* source)
+  {
+    db_->removeSource(static_cast<IngestSource*>(source));
+    delete source;
+  }
+
 
 }
@@ -0,0 +1,343 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/search_results_model.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <QRunnable>
+
+#include <swri_console/log_database.h>
+#include <swri_console/log_database_proxy_model.h>
+
+namespace swri_console
+{
+// Smaller scans aren't worth handing off to the thread pool.
+static const size_t PARALLEL_THRESHOLD = 4096;
+// Number of characters shown on each side of a match.
+static const int CONTEXT_LENGTH = 40;
+// How many entries a task searches between checks for cancellation.
+static const size_t CANCEL_CHECK_INTERVAL = 1024;
+
+// Matches entries the same way as the incremental search.
+static bool entryContains(const LogEntry &entry, const QString &text)
+{
+  return entry.text.join("|").contains(text, Qt::CaseInsensitive);
+}
+
+// Appends the entries in [begin, end) of the candidates that contain
+// the text.  Returns false if the token was cancelled first.
+static bool searchEntries(const LogSnapshot &log,
+                          const SearchMatches &candidates,
+                          size_t begin,
+                          size_t end,
+                          const QString &text,
+                          const CancelToken &token,
+                          SearchMatches *matches)
+{
+  for (size_t i = begin; i < end; i++) {
+    if ((i - begin) % CANCEL_CHECK_INTERVAL == 0 && token.isCancelled()) {
+      return false;
+    }
+    size_t log_index = candidates[i];
+    if (entryContains(log[log_index], text)) {
+      matches->push_back(log_index);
+    }
+  }
+  return true;
+}
+
+namespace
+{
+class FindTask : public QRunnable
+{
+ public:
+  FindTask(SearchResultsModel *model,
+           const boost::shared_ptr<QMutex> &emit_mutex,
+           quint64 search_id,
+           const LogSnapshot &log,
+           const boost::shared_ptr<const SearchMatches> &candidates,
+           size_t begin,
+           size_t end,
+           const QString &text,
+           const CancelToken &token) :
+    model_(model),
+    emit_mutex_(emit_mutex),
+    search_id_(search_id),
+    log_(log),
+    candidates_(candidates),
+    begin_(begin),
+    end_(end),
+    text_(text),
+    token_(token)
+  {
+  }
+
+  void run()
+  {
+    SearchMatches matches;
+    if (!searchEntries(log_, *candidates_, begin_, end_, text_, token_, &matches) ||
+        matches.empty()) {
+      return;
+    }
+
+    // The model cancels the token under this lock before it is
+    // destroyed.  The signal is queued to the GUI thread.
+    QMutexLocker lock(emit_mutex_.get());
+    if (!token_.isCancelled()) {
+      Q_EMIT model_->matchesFound(search_id_, matches);
+    }
+  }
+
+ private:
+  SearchResultsModel *model_;
+  boost::shared_ptr<QMutex> emit_mutex_;
+  quint64 search_id_;
+  LogSnapshot log_;
+  boost::shared_ptr<const SearchMatches> candidates_;
+  size_t begin_;
+  size_t end_;
+  QString text_;
+  CancelToken token_;
+};
+}  // namespace
+
+SearchResultsModel::SearchResultsModel(LogDatabase *db,
+                                       LogDatabaseProxyModel *proxy,
+                                       TaskExecutor *executor,
+                                       QObject *parent)
+  :
+  QAbstractListModel(parent),
+  db_(db),
+  proxy_(proxy),
+  executor_(executor),
+  search_id_(0),
+  emit_mutex_(new QMutex())
+{
+  QObject::connect(proxy_, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+                   this, SLOT(handleRowsInserted(const QModelIndex&, int, int)));
+  QObject::connect(proxy_, SIGNAL(modelReset()),
+                   this, SLOT(handleModelReset()));
+  QObject::connect(this, SIGNAL(matchesFound(quint64, const swri_console::SearchMatches&)),
+                   this, SLOT(handleMatchesFound(quint64, const swri_console::SearchMatches&)),
+                   Qt::QueuedConnection);
+}
+
+SearchResultsModel::~SearchResultsModel()
+{
+  QMutexLocker lock(emit_mutex_.get());
+  cancel_token_.cancel();
+}
+
+void SearchResultsModel::setSearchText(const QString &text)
+{
+  QString trimmed = text.trimmed();
+  if (trimmed == search_text_) {
+    return;
+  }
+
+  search_text_ = trimmed;
+  findAll();
+}
+
+void SearchResultsModel::findAll()
+{
+  cancel_token_.cancel();
+  cancel_token_ = CancelToken();
+  search_id_++;
+
+  beginResetModel();
+  matches_.clear();
+  endResetModel();
+
+  int rows = proxy_->rowCount(QModelIndex());
+  if (!search_text_.isEmpty() && rows > 0) {
+    findMatches(0, rows - 1);
+  }
+}
+
+void SearchResultsModel::findMatches(int first_row, int last_row)
+{
+  // A multi-line entry can span several rows, but it is only listed
+  // once.  Entries in chunks whose summary shows that they can't
+  // contain the text are dropped here.  The summaries join lines with
+  // spaces rather than '|', so they can't be used for text with a '|'.
+  const bool use_summaries = !search_text_.contains('|');
+  size_t chunk = std::numeric_limits<size_t>::max();
+  bool chunk_may_match = true;
+  boost::shared_ptr<SearchMatches> candidates(new SearchMatches());
+  for (int row = first_row; row <= last_row; row++) {
+    size_t log_index = proxy_->logIndex(row);
+    if (!candidates->empty() && candidates->back() == log_index) {
+      continue;
+    }
+    if (use_summaries && log_index / LogDatabase::CHUNK_SIZE != chunk) {
+      chunk = log_index / LogDatabase::CHUNK_SIZE;
+      chunk_may_match = db_->chunkSummary(log_index).mayContain(search_text_);
+    }
+    if (chunk_may_match) {
+      candidates->push_back(log_index);
+    }
+  }
+
+  // The tasks read from a snapshot so that they never touch the log
+  // while the GUI thread is appending to it.
+  LogSnapshot log = db_->log().snapshot();
+  if (candidates->size() < PARALLEL_THRESHOLD) {
+    SearchMatches matches;
+    searchEntries(log, *candidates, 0, candidates->size(), search_text_,
+                  CancelToken(), &matches);
+    addMatches(matches);
+    return;
+  }
+
+  // Use a few chunks per thread so that the threads finish at about
+  // the same time even if some chunks are slower to search.
+  size_t chunk_count = std::max(1, executor_->threadCount()) * 4;
+  size_t chunk_size = (candidates->size() + chunk_count - 1) / chunk_count;
+  for (size_t i = 0; i < chunk_count; i++) {
+    size_t begin = std::min(i * chunk_size, candidates->size());
+    size_t end = std::min(begin + chunk_size, candidates->size());
+    if (begin == end) {
+      break;
+    }
+    executor_->submit(new FindTask(this, emit_mutex_, search_id_, log, candidates,
+                                   begin, end, search_text_, cancel_token_),
+                      TaskExecutor::INTERACTIVE,
+                      cancel_token_);
+  }
+}
+
+void SearchResultsModel::handleMatchesFound(quint64 search_id, const SearchMatches &matches)
+{
+  if (search_id == search_id_) {
+    addMatches(matches);
+  }
+}
+
+void SearchResultsModel::addMatches(const SearchMatches &matches)
+{
+  // The rows of an expanded entry are inserted next to its first row,
+  // so it may already be listed.
+  SearchMatches added;
+  for (size_t i = 0; i < matches.size(); i++) {
+    if (!std::binary_search(matches_.begin(), matches_.end(), matches[i])) {
+      added.push_back(matches[i]);
+    }
+  }
+
+  // Chunks finish in any order, so each run of new matches that falls
+  // between the same two listed matches is inserted separately.
+  size_t i = 0;
+  while (i < added.size()) {
+    SearchMatches::iterator position = std::lower_bound(
+      matches_.begin(), matches_.end(), added[i]);
+    size_t j = i + 1;
+    while (j < added.size() &&
+           (position == matches_.end() || added[j] < *position)) {
+      j++;
+    }
+
+    int row = position - matches_.begin();
+    beginInsertRows(QModelIndex(), row, row + (j - i) - 1);
+    matches_.insert(matches_.begin() + row, added.begin() + i, added.begin() + j);
+    endInsertRows();
+    i = j;
+  }
+}
+
+void SearchResultsModel::handleRowsInserted(const QModelIndex &parent, int first, int last)
+{
+  if (parent.isValid() || search_text_.isEmpty()) {
+    return;
+  }
+
+  findMatches(first, last);
+}
+
+void SearchResultsModel::handleModelReset()
+{
+  if (!search_text_.isEmpty() || !matches_.empty()) {
+    findAll();
+  }
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const
+{
+  if (parent.isValid()) {
+    return 0;
+  }
+  return matches_.size();
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const
+{
+  if (index.parent().isValid() ||
+      index.row() < 0 ||
+      static_cast<size_t>(index.row()) >= matches_.size()) {
+    return QVariant();
+  }
+
+  const LogEntry &entry = db_->log()[matches_[index.row()]];
+  if (role == Qt::DisplayRole) {
+    // Show the first matching line around the match.
+    QString line;
+    int position = -1;
+    for (int i = 0; i < entry.text.size() && position < 0; i++) {
+      position = entry.text[i].indexOf(search_text_, 0, Qt::CaseInsensitive);
+      line = entry.text[i];
+    }
+    if (position < 0) {
+      // The match spans lines.
+      line = entry.text.join("|");
+      position = std::max(0, line.indexOf(search_text_, 0, Qt::CaseInsensitive));
+    }
+
+    int start = std::max(0, position - CONTEXT_LENGTH);
+    int end = std::min(line.size(), position + search_text_.size() + CONTEXT_LENGTH);
+    QString context = line.mid(start, end - start);
+    if (start > 0) {
+      context.prepend(QString::fromUtf8("\xe2\x80\xa6"));
+    }
+    if (end < line.size()) {
+      context.append(QString::fromUtf8("\xe2\x80\xa6"));
+    }
+
+    return QString("[%1] %2")
+      .arg(QString::fromStdString(db_->nodes().value(entry.node_id)))
+      .arg(context);
+  } else if (role == Qt::ToolTipRole) {
+    return entry.text.join("\n");
+  }
+
+  return QVariant();
+}
+}  // namespace swri_console
@@ -37,6 +37,7 @@ namespace swri_console
   const QString SettingsKeys::DISPLAY_LOGGER = "Identification/Logger";
   const QString SettingsKeys::DISPLAY_FUNCTION = "Identification/Function";
   const QString SettingsKeys::USE_REGEXPS = "Filters/UseRegexps";
+  const QString SettingsKeys::USE_QUERY_LANGUAGE = "Filters/UseQueryLanguage";
   const QString SettingsKeys::INCLUDE_FILTER = "Filters/IncludeFilter";
   const QString SettingsKeys::EXCLUDE_FILTER = "Filters/ExcludeFilter";
   const QString SettingsKeys::SHOW_DEBUG = "Severity/ShowDebug";
@@ -53,4 +54,12 @@ namespace swri_console
   const QString SettingsKeys::FATAL_COLOR = "Colors/FatalColor";
   const QString SettingsKeys::COLORIZE_LOGS = "Colors/ColorizeLogs";
   const QString SettingsKeys::ALTERNATE_LOG_ROW_COLORS = "Logs/AlternateRowColors";
+  const QString SettingsKeys::SHOW_DETAILS = "UI/ShowDetails";
+  const QString SettingsKeys::SORT_NODES_BY_RATE = "UI/SortNodesByRate";
+  const QString SettingsKeys::INGEST_MEMORY_BUDGET_MB = "Ingest/MemoryBudgetMB";
+  const QString SettingsKeys::INGEST_SHEDDING_THRESHOLD_MB = "Ingest/SheddingThresholdMB";
+  const QString SettingsKeys::NODE_RATE_LIMIT = "Ingest/NodeRateLimit";
+  const QString SettingsKeys::NODE_BURST = "Ingest/NodeBurst";
+  const QString SettingsKeys::LOCATION_RATE_LIMIT = "Ingest/LocationRateLimit";
+  const QString SettingsKeys::LOCATION_BURST = "Ingest/LocationBurst";
 }
@@ -0,0 +1,67 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/string_table.h>
+
+namespace swri_console
+{
+StringTable::StringTable()
+  :
+  data_(new Data()),
+  generation_(0)
+{
+}
+
+uint32_t StringTable::intern(const std::string &value)
+{
+  boost::unordered_map<std::string, uint32_t>::const_iterator it = data_->ids.find(value);
+  if (it != data_->ids.end()) {
+    return it->second;
+  }
+
+  // Copies only ever read the shared data, so make our own before
+  // changing it.  Copies are only made from the thread that owns the
+  // table, so the count can't go up behind our back.
+  if (!data_.unique()) {
+    data_.reset(new Data(*data_));
+  }
+
+  uint32_t id = data_->values.size();
+  data_->values.push_back(value);
+  data_->ids[value] = id;
+  return id;
+}
+
+void StringTable::clear()
+{
+  data_.reset(new Data());
+  generation_++;
+}
+}  // namespace swri_console
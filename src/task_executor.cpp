@@ -0,0 +1,279 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/task_executor.h>
+
+#include <algorithm>
+
+#include <QThread>
+
+namespace swri_console
+{
+const size_t TaskExecutor::NUM_PRIORITIES;
+
+CancelToken::CancelToken()
+  :
+  cancelled_(new QAtomicInt(0))
+{
+}
+
+void CancelToken::cancel()
+{
+  cancelled_->storeRelease(1);
+}
+
+bool CancelToken::isCancelled() const
+{
+  return cancelled_->loadAcquire() != 0;
+}
+
+namespace
+{
+class ReleaseTask : public QRunnable
+{
+ public:
+  explicit ReleaseTask(const boost::shared_ptr<const void> &object) :
+    object_(object)
+  {
+  }
+
+  void run()
+  {
+    object_.reset();
+  }
+
+ private:
+  boost::shared_ptr<const void> object_;
+};
+}  // namespace
+
+class TaskExecutor::Worker : public QThread
+{
+ public:
+  Worker(TaskExecutor *executor, size_t index) :
+    executor_(executor),
+    index_(index)
+  {
+  }
+
+ protected:
+  void run()
+  {
+    executor_->runWorker(index_);
+  }
+
+ private:
+  TaskExecutor *executor_;
+  size_t index_;
+};
+
+TaskExecutor::TaskExecutor(int thread_count)
+  :
+  next_queue_(0),
+  running_bulk_(0),
+  stopping_(false)
+{
+  if (thread_count <= 0) {
+    thread_count = QThread::idealThreadCount();
+  }
+  // There must be at least one thread that BULK tasks can't occupy.
+  thread_count = std::max(2, thread_count);
+  max_bulk_ = thread_count - 1;
+
+  pending_[INTERACTIVE] = 0;
+  pending_[BULK] = 0;
+  pending_[RECLAIM] = 0;
+
+  for (int i = 0; i < thread_count; i++) {
+    queues_.push_back(new WorkQueue());
+    workers_.push_back(new Worker(this, i));
+  }
+  for (size_t i = 0; i < workers_.size(); i++) {
+    workers_[i]->start();
+  }
+}
+
+TaskExecutor::~TaskExecutor()
+{
+  shutdown();
+}
+
+void TaskExecutor::submit(QRunnable *task, Priority priority, const CancelToken &token)
+{
+  QueuedTask queued;
+  queued.task = task;
+  queued.token = token;
+
+  QMutexLocker lock(&mutex_);
+  if (stopping_) {
+    finishTask(queued, false);
+    return;
+  }
+
+  int worker = currentWorker();
+  if (worker < 0) {
+    unsigned int next = next_queue_.fetchAndAddRelaxed(1);
+    worker = next % queues_.size();
+  }
+
+  {
+    QMutexLocker queue_lock(&queues_[worker]->mutex);
+    queues_[worker]->tasks[priority].push_back(queued);
+  }
+  pending_[priority]++;
+  wake_.wakeOne();
+}
+
+void TaskExecutor::shutdown()
+{
+  {
+    QMutexLocker lock(&mutex_);
+    if (stopping_) {
+      return;
+    }
+    stopping_ = true;
+    wake_.wakeAll();
+  }
+
+  for (size_t i = 0; i < workers_.size(); i++) {
+    workers_[i]->wait();
+    delete workers_[i];
+  }
+  workers_.clear();
+
+  for (size_t i = 0; i < queues_.size(); i++) {
+    for (size_t p = 0; p < NUM_PRIORITIES; p++) {
+      std::deque<QueuedTask> &tasks = queues_[i]->tasks[p];
+      for (size_t j = 0; j < tasks.size(); j++) {
+        finishTask(tasks[j], false);
+      }
+    }
+    delete queues_[i];
+  }
+  queues_.clear();
+}
+
+QRunnable* TaskExecutor::createReleaseTask(const boost::shared_ptr<const void> &object)
+{
+  return new ReleaseTask(object);
+}
+
+int TaskExecutor::currentWorker() const
+{
+  QThread *thread = QThread::currentThread();
+  for (size_t i = 0; i < workers_.size(); i++) {
+    if (workers_[i] == thread) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+bool TaskExecutor::reserveTask(Priority *priority)
+{
+  QMutexLocker lock(&mutex_);
+  while (!stopping_) {
+    if (pending_[INTERACTIVE] > 0) {
+      pending_[INTERACTIVE]--;
+      *priority = INTERACTIVE;
+      return true;
+    }
+    if (pending_[RECLAIM] > 0) {
+      pending_[RECLAIM]--;
+      *priority = RECLAIM;
+      return true;
+    }
+    if (pending_[BULK] > 0 && running_bulk_ < max_bulk_) {
+      pending_[BULK]--;
+      running_bulk_++;
+      *priority = BULK;
+      return true;
+    }
+    wake_.wait(&mutex_);
+  }
+  return false;
+}
+
+bool TaskExecutor::takeTask(size_t worker, Priority priority, QueuedTask *task)
+{
+  // The worker's own queue is checked first, newest task first.  The
+  // other queues are stolen from oldest task first.
+  for (size_t i = 0; i < queues_.size(); i++) {
+    WorkQueue *queue = queues_[(worker + i) % queues_.size()];
+    QMutexLocker lock(&queue->mutex);
+    std::deque<QueuedTask> &tasks = queue->tasks[priority];
+    if (tasks.empty()) {
+      continue;
+    }
+    if (i == 0) {
+      *task = tasks.back();
+      tasks.pop_back();
+    } else {
+      *task = tasks.front();
+      tasks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+void TaskExecutor::runWorker(size_t worker)
+{
+  Priority priority;
+  while (reserveTask(&priority)) {
+    // Every reservation is backed by a queued task, but the scan isn't
+    // atomic and can miss it while other workers take and submit tasks.
+    QueuedTask task;
+    while (!takeTask(worker, priority, &task)) {
+      QThread::yieldCurrentThread();
+    }
+
+    finishTask(task, !task.token.isCancelled());
+
+    if (priority == BULK) {
+      QMutexLocker lock(&mutex_);
+      running_bulk_--;
+      if (pending_[BULK] > 0) {
+        wake_.wakeOne();
+      }
+    }
+  }
+}
+
+void TaskExecutor::finishTask(const QueuedTask &task, bool run)
+{
+  if (run) {
+    task.task->run();
+  }
+  if (task.task->autoDelete()) {
+    delete task.task;
+  }
+}
+}  // namespace swri_console
@@ -0,0 +1,143 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <swri_console/text_table.h>
+
+#include <utility>
+
+#include <QHash>
+
+#include <boost/shared_ptr.hpp>
+
+#include <swri_console/task_executor.h>
+
+namespace swri_console
+{
+// Returns true if the lines joined with newlines are equal to the text.
+static bool sameText(const QStringList &lines, const QString &text)
+{
+  int position = 0;
+  for (int i = 0; i < lines.size(); i++) {
+    if (i > 0) {
+      if (position >= text.size() || text[position] != QChar('\n')) {
+        return false;
+      }
+      position++;
+    }
+    if (text.midRef(position, lines[i].size()) != lines[i]) {
+      return false;
+    }
+    position += lines[i].size();
+  }
+  return position == text.size();
+}
+
+TextTable::TextTable()
+  :
+  generation_(0)
+{
+}
+
+uint32_t TextTable::intern(const std::string &text)
+{
+  QString body(text.c_str());
+  uint hash = qHash(body);
+
+  typedef boost::unordered_multimap<uint, uint32_t>::const_iterator Iterator;
+  std::pair<Iterator, Iterator> range = ids_.equal_range(hash);
+  for (Iterator it = range.first; it != range.second; ++it) {
+    if (sameText(values_[it->second], body)) {
+      uses_[it->second]++;
+      return it->second;
+    }
+  }
+
+  uint32_t id;
+  if (free_ids_.empty()) {
+    id = values_.size();
+    values_.push_back(body.split('\n'));
+    uses_.push_back(1);
+    versions_.push_back(0);
+  } else {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+    values_[id] = body.split('\n');
+    uses_[id] = 1;
+    versions_[id]++;
+  }
+  ids_.insert(std::make_pair(hash, id));
+  return id;
+}
+
+void TextTable::release(uint32_t id)
+{
+  if (id >= uses_.size() || uses_[id] == 0 || --uses_[id] > 0) {
+    return;
+  }
+
+  uint hash = qHash(values_[id].join("\n"));
+  typedef boost::unordered_multimap<uint, uint32_t>::iterator Iterator;
+  std::pair<Iterator, Iterator> range = ids_.equal_range(hash);
+  for (Iterator it = range.first; it != range.second; ++it) {
+    if (it->second == id) {
+      ids_.erase(it);
+      break;
+    }
+  }
+  values_[id] = QStringList();
+  free_ids_.push_back(id);
+}
+
+namespace
+{
+struct ClearedTexts
+{
+  std::deque<QStringList> values;
+  boost::unordered_multimap<uint, uint32_t> ids;
+  std::deque<uint32_t> uses;
+  std::deque<uint32_t> versions;
+  std::vector<uint32_t> free_ids;
+};
+}  // namespace
+
+void TextTable::clear(TaskExecutor *executor)
+{
+  boost::shared_ptr<ClearedTexts> old(new ClearedTexts());
+  old->values.swap(values_);
+  old->ids.swap(ids_);
+  old->uses.swap(uses_);
+  old->versions.swap(versions_);
+  old->free_ids.swap(free_ids_);
+  if (executor) {
+    executor->release(old);
+  }
+  generation_++;
+}
+}  // namespace swri_console
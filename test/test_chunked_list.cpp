@@ -0,0 +1,133 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <swri_console/chunked_list.h>
+
+using swri_console::ChunkedList;
+
+static const size_t BLOCK = ChunkedList<int>::BLOCK_SIZE;
+
+static std::vector<int> range(int first, int count)
+{
+  std::vector<int> values;
+  for (int i = 0; i < count; i++) {
+    values.push_back(first + i);
+  }
+  return values;
+}
+
+static void expectEqual(const std::deque<int> &expected, const ChunkedList<int> &list)
+{
+  ASSERT_EQ(expected.size(), list.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_EQ(expected[i], list[i]) << "index " << i;
+  }
+  std::deque<int> copied;
+  list.appendTo(&copied);
+  EXPECT_TRUE(copied == expected);
+}
+
+TEST(ChunkedListTest, MatchesADeque)
+{
+  ChunkedList<int> list;
+  std::deque<int> expected;
+  srand(1);
+  for (int step = 0; step < 60; step++) {
+    std::vector<int> values = range(step * 100000, rand() % (3 * BLOCK));
+    size_t index = expected.empty() ? 0 : rand() % expected.size();
+    switch (rand() % 4) {
+      case 0:
+        list.append(values.begin(), values.end());
+        expected.insert(expected.end(), values.begin(), values.end());
+        break;
+      case 1:
+        list.prepend(values.begin(), values.end());
+        expected.insert(expected.begin(), values.begin(), values.end());
+        break;
+      case 2:
+        list.insert(index, values.begin(), values.end());
+        expected.insert(expected.begin() + index, values.begin(), values.end());
+        break;
+      default: {
+        size_t last = std::min(expected.size(), index + rand() % (2 * BLOCK));
+        list.erase(index, last);
+        expected.erase(expected.begin() + index, expected.begin() + last);
+        break;
+      }
+    }
+    expectEqual(expected, list);
+  }
+}
+
+TEST(ChunkedListTest, CopiesAreIndependent)
+{
+  ChunkedList<int> list;
+  std::vector<int> values = range(0, 3 * BLOCK);
+  list.append(values.begin(), values.end());
+
+  ChunkedList<int> copy = list;
+  std::vector<int> more = range(-10, 10);
+  list.append(values.begin(), values.end());
+  list.prepend(more.begin(), more.end());
+  list.insert(BLOCK, more.begin(), more.end());
+  list.erase(5, 2 * BLOCK);
+
+  std::deque<int> expected(values.begin(), values.end());
+  expectEqual(expected, copy);
+}
+
+TEST(ChunkedListTest, LowerBound)
+{
+  ChunkedList<int> list;
+  std::vector<int> evens;
+  for (size_t i = 0; i < 3 * BLOCK; i++) {
+    evens.push_back(2 * i);
+  }
+  list.append(evens.begin(), evens.end());
+
+  EXPECT_EQ(0u, list.lowerBound(-1));
+  EXPECT_EQ(0u, list.lowerBound(0));
+  EXPECT_EQ(1u, list.lowerBound(1));
+  EXPECT_EQ(BLOCK, list.lowerBound(2 * BLOCK));
+  EXPECT_EQ(BLOCK + 1, list.lowerBound(2 * BLOCK + 1));
+  EXPECT_EQ(list.size(), list.lowerBound(6 * BLOCK));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <gtest/gtest.h>
+
+#include <swri_console/field_filter.h>
+#include <swri_console/string_table.h>
+
+using swri_console::FieldFilter;
+using swri_console::StringTable;
+
+TEST(FieldFilterTest, FieldTerms)
+{
+  EXPECT_TRUE(FieldFilter::isFieldTerm("node:planner"));
+  EXPECT_TRUE(FieldFilter::isFieldTerm("File~^src/"));
+  EXPECT_TRUE(FieldFilter::isFieldTerm("function:run"));
+}
+
+TEST(FieldFilterTest, PlainTextIsNotAFieldTerm)
+{
+  // A space after the separator reads as prose, not a filter.
+  EXPECT_FALSE(FieldFilter::isFieldTerm("file: not found"));
+  EXPECT_FALSE(FieldFilter::isFieldTerm("node: shutting down"));
+  // The field has to be spelled out right up to the separator.
+  EXPECT_FALSE(FieldFilter::isFieldTerm("file :x"));
+  EXPECT_FALSE(FieldFilter::isFieldTerm("profile:x"));
+  EXPECT_FALSE(FieldFilter::isFieldTerm("could not open file:x"));
+  EXPECT_FALSE(FieldFilter::isFieldTerm("host:port"));
+  EXPECT_FALSE(FieldFilter::isFieldTerm("node:"));
+  EXPECT_FALSE(FieldFilter::isFieldTerm(":x"));
+}
+
+TEST(FieldFilterTest, TermsSelectValues)
+{
+  StringTable files;
+  uint32_t planner = files.intern("src/planner.cpp");
+  uint32_t driver = files.intern("src/driver.cpp");
+
+  FieldFilter filter("file");
+  QStringList includes;
+  includes << "file:PLANNER" << "file: not found" << "node:driver";
+  EXPECT_TRUE(filter.setTerms(includes, QStringList()));
+  EXPECT_TRUE(filter.accepts(files, planner));
+  EXPECT_FALSE(filter.accepts(files, driver));
+  EXPECT_FALSE(filter.setTerms(includes, QStringList()));
+}
+
+TEST(FieldFilterTest, TextTermsDontWidenFieldTerms)
+{
+  StringTable files;
+  uint32_t planner = files.intern("src/planner.cpp");
+  uint32_t driver = files.intern("src/driver.cpp");
+
+  // Field terms are AND-ed with the text terms, so "error" doesn't let
+  // entries from other files through the file filter.
+  QStringList includes;
+  includes << "error" << "file:planner";
+  FieldFilter file_filter("file");
+  file_filter.setTerms(includes, QStringList());
+  EXPECT_TRUE(file_filter.accepts(files, planner));
+  EXPECT_FALSE(file_filter.accepts(files, driver));
+
+  // A field without terms of its own accepts every value.
+  StringTable nodes;
+  uint32_t node = nodes.intern("/driver");
+  FieldFilter node_filter("node");
+  node_filter.setTerms(includes, QStringList());
+  EXPECT_TRUE(node_filter.isEmpty());
+  EXPECT_TRUE(node_filter.accepts(nodes, node));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
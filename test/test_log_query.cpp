@@ -0,0 +1,274 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <rosgraph_msgs/Log.h>
+
+#include <swri_console/ingest_source.h>
+#include <swri_console/log_database.h>
+#include <swri_console/log_query.h>
+
+using swri_console::IngestSource;
+using swri_console::LogDatabase;
+using swri_console::LogQuery;
+
+static void addMessage(IngestSource *source,
+                       const std::string &node,
+                       uint8_t level,
+                       const std::string &text,
+                       double stamp = 100.0)
+{
+  rosgraph_msgs::LogPtr msg(new rosgraph_msgs::Log());
+  msg->header.stamp = ros::Time(stamp);
+  msg->name = node;
+  msg->level = level;
+  msg->msg = text;
+  msg->file = node + ".cpp";
+  msg->function = "run";
+  msg->line = 1;
+  source->addMessage(msg);
+}
+
+class LogQueryTest : public testing::Test
+{
+ protected:
+  virtual void SetUp()
+  {
+    // Messages go through an IngestSource like they do in the application,
+    // which delivers them directly since the source and database share a
+    // thread.
+    db_.addSource(&source_);
+    addMessage(&source_, "planner", rosgraph_msgs::Log::INFO, "computing path");
+    addMessage(&source_, "planner", rosgraph_msgs::Log::WARN, "retry planning");
+    addMessage(&source_, "driver", rosgraph_msgs::Log::ERROR, "motor fault");
+    addMessage(&source_, "driver", rosgraph_msgs::Log::DEBUG, "heartbeat");
+    addMessage(&source_, "camera", rosgraph_msgs::Log::INFO, "frame dropped; retry");
+    source_.flush();
+  }
+
+  // Returns the indices of the entries that a query accepts, separated
+  // by commas, or "invalid" if it doesn't parse.
+  std::string matches(const std::string &text)
+  {
+    LogQuery query(&db_);
+    if (!query.parse(QString::fromStdString(text))) {
+      return "invalid";
+    }
+
+    std::ostringstream out;
+    for (size_t i = 0; i < db_.log().size(); i++) {
+      if (query.accepts(db_.log()[i])) {
+        if (out.tellp() > 0) {
+          out << ",";
+        }
+        out << i;
+      }
+    }
+    return out.str();
+  }
+
+  LogDatabase db_;
+  IngestSource source_;
+};
+
+TEST_F(LogQueryTest, EmptyQueryAcceptsEverything)
+{
+  EXPECT_EQ("0,1,2,3,4", matches(""));
+  EXPECT_EQ("0,1,2,3,4", matches("   "));
+}
+
+TEST_F(LogQueryTest, AndBindsTighterThanOr)
+{
+  EXPECT_EQ("1,4", matches("node:camera or node:planner and level>=WARN"));
+  EXPECT_EQ("1,4", matches("node:planner and level>=WARN or node:camera"));
+  EXPECT_EQ("1", matches("(node:camera or node:planner) and level>=WARN"));
+}
+
+TEST_F(LogQueryTest, NotAppliesToTheNextOperand)
+{
+  EXPECT_EQ("2,4", matches("not node:planner and level>=INFO"));
+  EXPECT_EQ("0,2,4", matches("not node:planner and level>=INFO or computing"));
+  EXPECT_EQ("4", matches("not (node:planner or node:driver)"));
+  EXPECT_EQ("2,3", matches("not not node:driver"));
+  EXPECT_EQ("0,1,4", matches("not node:driver"));
+}
+
+TEST_F(LogQueryTest, KeywordsAndFieldsIgnoreCase)
+{
+  EXPECT_EQ("0", matches("NODE:planner AND NOT msg:retry"));
+  EXPECT_EQ("1,2", matches("Level>=warn"));
+}
+
+TEST_F(LogQueryTest, LevelComparisons)
+{
+  EXPECT_EQ("0,3,4", matches("level<WARN"));
+  EXPECT_EQ("1,2,3", matches("level!=INFO"));
+  EXPECT_EQ("2", matches("level=ERROR"));
+  EXPECT_EQ("1,2", matches("level>INFO"));
+}
+
+TEST_F(LogQueryTest, MessagePredicates)
+{
+  EXPECT_EQ("1,4", matches("retry"));
+  EXPECT_EQ("2", matches("\"motor fault\""));
+  EXPECT_EQ("1", matches("msg~^retry"));
+  EXPECT_EQ("4", matches("msg~\"dropped; re\""));
+}
+
+TEST_F(LogQueryTest, FieldPatterns)
+{
+  // ':' is a substring match unless the pattern has wildcards, in which
+  // case it must match the whole value.
+  EXPECT_EQ("2,3", matches("node:dri"));
+  EXPECT_EQ("2,3", matches("node:dri*"));
+  EXPECT_EQ("", matches("node:dri?"));
+  EXPECT_EQ("0,1", matches("file~^plan.*\\.cpp$"));
+  EXPECT_EQ("0,1,2,3,4", matches("function:run"));
+}
+
+TEST_F(LogQueryTest, TimeComparisons)
+{
+  // Times count from the first message, which is at 100 s.
+  db_.clear();
+  addMessage(&source_, "planner", rosgraph_msgs::Log::INFO, "start", 100.0);
+  addMessage(&source_, "planner", rosgraph_msgs::Log::INFO, "step", 101.0);
+  addMessage(&source_, "driver", rosgraph_msgs::Log::WARN, "slip", 102.5);
+  addMessage(&source_, "driver", rosgraph_msgs::Log::INFO, "stop", 104.0);
+  source_.flush();
+
+  EXPECT_EQ("0", matches("time<1"));
+  EXPECT_EQ("0,1", matches("time<=1"));
+  EXPECT_EQ("3", matches("time>2.5"));
+  EXPECT_EQ("2,3", matches("time >= 2.5"));
+  EXPECT_EQ("1,3", matches("time>=1 and not level>=WARN"));
+  EXPECT_EQ("invalid", matches("time=1"));
+  EXPECT_EQ("invalid", matches("time>soon"));
+}
+
+TEST_F(LogQueryTest, ChunkSummariesBoundTheQuery)
+{
+  // The first chunk is INFO "frame" messages at 100 s, and the second
+  // starts 100 s later.
+  db_.clear();
+  for (size_t i = 0; i < LogDatabase::CHUNK_SIZE; i++) {
+    addMessage(&source_, "camera", rosgraph_msgs::Log::INFO, "frame", 100.0);
+  }
+  addMessage(&source_, "planner", rosgraph_msgs::Log::WARN, "retry planning", 200.0);
+  source_.flush();
+  const swri_console::LogChunkSummary &first = db_.chunkSummary(0);
+  const swri_console::LogChunkSummary &second = db_.chunkSummary(LogDatabase::CHUNK_SIZE);
+
+  LogQuery query(&db_);
+  ASSERT_TRUE(query.parse("time>=50"));
+  EXPECT_FALSE(query.mayMatch(first));
+  EXPECT_TRUE(query.mayMatch(second));
+
+  ASSERT_TRUE(query.parse("time<50"));
+  EXPECT_TRUE(query.mayMatch(first));
+  EXPECT_FALSE(query.mayMatch(second));
+
+  ASSERT_TRUE(query.parse("level>=WARN or retry"));
+  EXPECT_FALSE(query.mayMatch(first));
+  EXPECT_TRUE(query.mayMatch(second));
+
+  ASSERT_TRUE(query.parse("level>=WARN and time<50"));
+  EXPECT_FALSE(query.mayMatch(first));
+  EXPECT_FALSE(query.mayMatch(second));
+
+  // Negations can't rule anything out.
+  ASSERT_TRUE(query.parse("not time>=50"));
+  EXPECT_TRUE(query.mayMatch(first));
+  EXPECT_TRUE(query.mayMatch(second));
+}
+
+TEST_F(LogQueryTest, InvalidQueriesAreRejected)
+{
+  EXPECT_EQ("invalid", matches("node:planner and"));
+  EXPECT_EQ("invalid", matches("(level>=WARN"));
+  EXPECT_EQ("invalid", matches("level>=WARN)"));
+  EXPECT_EQ("invalid", matches("level>=LOUD"));
+  EXPECT_EQ("invalid", matches("colour:red"));
+  EXPECT_EQ("invalid", matches("msg~\"(\""));
+  EXPECT_EQ("invalid", matches("\"unterminated"));
+  EXPECT_EQ("invalid", matches("not"));
+
+  LogQuery query(&db_);
+  EXPECT_FALSE(query.parse("node:"));
+  EXPECT_FALSE(query.isValid());
+  EXPECT_FALSE(query.errorString().isEmpty());
+  // An invalid query doesn't hide anything.
+  EXPECT_TRUE(query.accepts(db_.log()[0]));
+}
+
+TEST_F(LogQueryTest, ResultsDontDependOnThePlan)
+{
+  // Skew the statistics so that the planner orders the predicates
+  // differently.
+  for (int i = 0; i < 1000; i++) {
+    addMessage(&source_, "camera", rosgraph_msgs::Log::INFO, "frame");
+  }
+  source_.flush();
+
+  LogQuery query(&db_);
+  ASSERT_TRUE(query.parse("node:camera and level>=WARN or not node:camera and retry"));
+  query.refreshPlan();
+  for (size_t i = 0; i < db_.log().size(); i++) {
+    EXPECT_EQ(i == 1, query.accepts(db_.log()[i])) << "entry " << i;
+  }
+}
+
+TEST_F(LogQueryTest, CachedVerdictsSurviveClear)
+{
+  LogQuery query(&db_);
+  ASSERT_TRUE(query.parse("node:planner and retry"));
+  EXPECT_TRUE(query.accepts(db_.log()[1]));
+
+  // Clearing reassigns the IDs, so the driver now has the planner's old
+  // node ID and the heartbeat has the ID that "retry planning" had.
+  db_.clear();
+  addMessage(&source_, "driver", rosgraph_msgs::Log::WARN, "computing path");
+  addMessage(&source_, "driver", rosgraph_msgs::Log::WARN, "heartbeat");
+  addMessage(&source_, "planner", rosgraph_msgs::Log::WARN, "retry planning");
+  source_.flush();
+
+  EXPECT_FALSE(query.accepts(db_.log()[0]));
+  EXPECT_FALSE(query.accepts(db_.log()[1]));
+  EXPECT_TRUE(query.accepts(db_.log()[2]));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
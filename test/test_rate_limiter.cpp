@@ -0,0 +1,226 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rosgraph_msgs/Log.h>
+
+#include <swri_console/rate_limiter.h>
+
+using swri_console::RateLimiter;
+
+static const uint8_t INFO = rosgraph_msgs::Log::INFO;
+
+// Offers count INFO messages from node 0 at file 0, line 1 and returns
+// how many were accepted.
+static int offer(RateLimiter *limiter, int count, double stamp, uint8_t level = INFO)
+{
+  int accepted = 0;
+  for (int i = 0; i < count; i++) {
+    if (limiter->accept(0, 0, 1, level, ros::Time(stamp))) {
+      accepted++;
+    }
+  }
+  return accepted;
+}
+
+TEST(RateLimiterTest, DisabledByDefault)
+{
+  RateLimiter limiter;
+  EXPECT_EQ(10000, offer(&limiter, 10000, 100.0));
+
+  std::vector<RateLimiter::Suppression> summaries;
+  limiter.takeSummaries(true, &summaries);
+  EXPECT_TRUE(summaries.empty());
+}
+
+TEST(RateLimiterTest, BurstThenSustainedRate)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 5.0);
+
+  // A full bucket allows a burst.
+  EXPECT_EQ(5, offer(&limiter, 20, 100.0));
+  // Tokens come back at the sustained rate.
+  EXPECT_EQ(1, offer(&limiter, 20, 100.15));
+  EXPECT_EQ(2, offer(&limiter, 20, 100.35));
+  // But never more than the burst size.
+  EXPECT_EQ(5, offer(&limiter, 20, 200.0));
+}
+
+TEST(RateLimiterTest, BucketsArePerNode)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(1.0, 1.0);
+
+  EXPECT_TRUE(limiter.accept(0, 0, 1, INFO, ros::Time(100.0)));
+  EXPECT_FALSE(limiter.accept(0, 0, 1, INFO, ros::Time(100.0)));
+  EXPECT_TRUE(limiter.accept(1, 0, 1, INFO, ros::Time(100.0)));
+}
+
+TEST(RateLimiterTest, LocationLimit)
+{
+  RateLimiter limiter;
+  limiter.setLocationLimit(1.0, 2.0);
+
+  EXPECT_EQ(2, offer(&limiter, 10, 100.0));
+  // Another line of the same file has its own bucket.
+  EXPECT_TRUE(limiter.accept(0, 0, 2, INFO, ros::Time(100.0)));
+
+  std::vector<RateLimiter::Suppression> summaries;
+  limiter.takeSummaries(true, &summaries);
+  ASSERT_EQ(1u, summaries.size());
+  EXPECT_TRUE(summaries[0].by_location);
+  EXPECT_EQ(0u, summaries[0].file_id);
+  EXPECT_EQ(1u, summaries[0].line);
+  EXPECT_EQ(8u, summaries[0].count);
+}
+
+TEST(RateLimiterTest, WarningsAreNeverSuppressed)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 2.0);
+
+  EXPECT_EQ(100, offer(&limiter, 100, 100.0, rosgraph_msgs::Log::WARN));
+  EXPECT_EQ(100, offer(&limiter, 100, 100.0, rosgraph_msgs::Log::ERROR));
+  EXPECT_EQ(100, offer(&limiter, 100, 100.0, rosgraph_msgs::Log::FATAL));
+  // They don't use up the tokens either.
+  EXPECT_EQ(2, offer(&limiter, 10, 100.0));
+  EXPECT_EQ(100, offer(&limiter, 100, 100.0, rosgraph_msgs::Log::WARN));
+}
+
+TEST(RateLimiterTest, SummariesAreDueOncePerInterval)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 5.0);
+  std::vector<RateLimiter::Suppression> summaries;
+
+  EXPECT_EQ(5, offer(&limiter, 12, 100.0));
+  limiter.takeSummaries(false, &summaries);
+  EXPECT_TRUE(summaries.empty());
+
+  EXPECT_EQ(0, offer(&limiter, 3, 100.05, rosgraph_msgs::Log::DEBUG));
+  limiter.takeSummaries(false, &summaries);
+  EXPECT_TRUE(summaries.empty());
+
+  // A second later the summary is due, even though this message is
+  // accepted.
+  EXPECT_EQ(1, offer(&limiter, 1, 101.0));
+  limiter.takeSummaries(false, &summaries);
+  ASSERT_EQ(1u, summaries.size());
+  EXPECT_EQ(0u, summaries[0].node_id);
+  EXPECT_FALSE(summaries[0].by_location);
+  EXPECT_EQ(10u, summaries[0].count);
+  EXPECT_EQ(INFO, summaries[0].level);
+  EXPECT_EQ(ros::Time(100.05), summaries[0].stamp);
+
+  // The count starts over after a summary.
+  summaries.clear();
+  limiter.takeSummaries(true, &summaries);
+  EXPECT_TRUE(summaries.empty());
+}
+
+TEST(RateLimiterTest, AdvancingTheClockMakesSummariesDue)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 1.0);
+  std::vector<RateLimiter::Suppression> summaries;
+
+  // A storm that stops without any later messages.
+  EXPECT_EQ(1, offer(&limiter, 4, 100.0));
+  limiter.advanceTo(ros::Time(100.5));
+  limiter.takeSummaries(false, &summaries);
+  EXPECT_TRUE(summaries.empty());
+
+  limiter.advanceTo(ros::Time(101.0));
+  limiter.takeSummaries(false, &summaries);
+  ASSERT_EQ(1u, summaries.size());
+  EXPECT_EQ(3u, summaries[0].count);
+
+  // Going backwards is ignored.
+  summaries.clear();
+  EXPECT_EQ(1, offer(&limiter, 2, 101.0));
+  limiter.advanceTo(ros::Time(50.0));
+  limiter.takeSummaries(false, &summaries);
+  EXPECT_TRUE(summaries.empty());
+}
+
+TEST(RateLimiterTest, ForcedSummariesIgnoreTheInterval)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 1.0);
+  std::vector<RateLimiter::Suppression> summaries;
+
+  EXPECT_EQ(1, offer(&limiter, 4, 100.0));
+  limiter.takeSummaries(true, &summaries);
+  ASSERT_EQ(1u, summaries.size());
+  EXPECT_EQ(3u, summaries[0].count);
+
+  summaries.clear();
+  limiter.takeSummaries(true, &summaries);
+  EXPECT_TRUE(summaries.empty());
+}
+
+TEST(RateLimiterTest, StampsGoingBackRestartTheBucket)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 5.0);
+
+  EXPECT_EQ(5, offer(&limiter, 10, 1000.0));
+  // Jitter between publishers doesn't refill the bucket...
+  EXPECT_EQ(0, offer(&limiter, 10, 999.9));
+  // ...but a jump back further than the refill time (0.5 s) does, for
+  // example when an older bag file is loaded.
+  EXPECT_EQ(5, offer(&limiter, 10, 10.0));
+  // And the bucket refills from the new time on.
+  EXPECT_EQ(1, offer(&limiter, 10, 10.15));
+}
+
+TEST(RateLimiterTest, ClearForgetsEverything)
+{
+  RateLimiter limiter;
+  limiter.setNodeLimit(10.0, 5.0);
+
+  EXPECT_EQ(5, offer(&limiter, 10, 100.0));
+  limiter.clear();
+
+  std::vector<RateLimiter::Suppression> summaries;
+  limiter.takeSummaries(true, &summaries);
+  EXPECT_TRUE(summaries.empty());
+  EXPECT_EQ(5, offer(&limiter, 10, 100.0));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <gtest/gtest.h>
+
+#include <QRegExp>
+#include <QStringList>
+
+#include <swri_console/regexp_prefilter.h>
+
+using swri_console::RegExpPrefilter;
+
+// Texts that exercise the patterns below: words that the patterns'
+// literals appear in, punctuation that escapes match, and near misses.
+static const char *TEXTS[] = {
+  "",
+  "timeout",
+  "timeout on socket 3",
+  "socket timeout",
+  "Timeout waiting for transform",
+  "error: failed",
+  "warning: failed",
+  "fail",
+  "color colour",
+  "colr",
+  "abc",
+  "ac",
+  "abbbc",
+  "a.c",
+  "a+c",
+  "x(y)z",
+  "[brackets]",
+  "path/to/file.cpp:42",
+  "value=0x1F",
+  "tab\there",
+  "a|b",
+  "cost 12.5 ms",
+  "sensor_3 sensor_12",
+  "retry 1 of 5",
+  "]",
+  "\\backslash\\",
+  "{braces}",
+  "aaaa",
+  "foofoo",
+  "barbaz",
+};
+
+// Patterns with alternation, optional parts, classes, escapes and
+// repetition, which are where a literal extractor could wrongly demand
+// text that a match doesn't contain.
+static const char *PATTERNS[] = {
+  "timeout",
+  "timeout.*socket",
+  "socket|timeout",
+  "(socket|timeout) on",
+  "(error|warning): failed",
+  "fail(ed)?",
+  "colou?r",
+  "colo(u)?r",
+  "colo(?:u)?r",
+  "ab*c",
+  "ab+c",
+  "ab{0,2}c",
+  "ab{2,}c",
+  "ab{1}c",
+  "a.c",
+  "a\\.c",
+  "a\\+c",
+  "a[.+]c",
+  "a[^b]c",
+  "[]a]",
+  "\\[brackets\\]",
+  "x\\(y\\)z",
+  "x(\\(y\\))?z",
+  "file\\.cpp:\\d+",
+  "0x[0-9A-F]+",
+  "\\x0041bc",
+  "tab\\there",
+  "a\\|b",
+  "cost \\d+\\.\\d+ ms",
+  "sensor_\\d{1,2}",
+  "retry \\d of \\d",
+  "^abc$",
+  "\\babc\\b",
+  "(?=abc)abc",
+  "(?!abd)abc",
+  "\\\\backslash",
+  "\\{braces\\}",
+  "(a)\\1",
+  "(foo)+",
+  "(foo){2}",
+  "(foo){0}bar",
+  "bar(baz|qux)",
+  "ba(r|z)+",
+  "(a|)bc",
+  "((ab)|c)c",
+  "[a-c]+",
+  "[",
+  "(abc",
+  "abc)",
+  "a{",
+  "a{x}c",
+};
+
+TEST(RegExpPrefilterTest, NeverRejectsAMatch)
+{
+  for (size_t p = 0; p < sizeof(PATTERNS) / sizeof(PATTERNS[0]); p++) {
+    for (int sensitive = 0; sensitive < 2; sensitive++) {
+      QRegExp regexp(PATTERNS[p], sensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+      RegExpPrefilter prefilter;
+      prefilter.setRegExp(regexp);
+
+      for (size_t t = 0; t < sizeof(TEXTS) / sizeof(TEXTS[0]); t++) {
+        QString text(TEXTS[t]);
+        if (regexp.isValid() && regexp.indexIn(text) >= 0) {
+          EXPECT_TRUE(prefilter.mayMatch(text))
+            << "pattern \"" << PATTERNS[p] << "\" matches \"" << TEXTS[t]
+            << "\" but was rejected by literals \""
+            << prefilter.literals().join("\", \"").toStdString() << "\"";
+        }
+      }
+    }
+  }
+}
+
+TEST(RegExpPrefilterTest, FixedStringsAreTheirOwnLiteral)
+{
+  QRegExp regexp("a.c", Qt::CaseSensitive, QRegExp::FixedString);
+  RegExpPrefilter prefilter;
+  prefilter.setRegExp(regexp);
+  EXPECT_EQ(QStringList("a.c"), prefilter.literals());
+  EXPECT_TRUE(prefilter.mayMatch("xa.cx"));
+  EXPECT_FALSE(prefilter.mayMatch("abc"));
+}
+
+TEST(RegExpPrefilterTest, WildcardsHaveNoLiterals)
+{
+  RegExpPrefilter prefilter;
+  prefilter.setRegExp(QRegExp("time*", Qt::CaseSensitive, QRegExp::Wildcard));
+  EXPECT_TRUE(prefilter.literals().isEmpty());
+}
+
+TEST(RegExpPrefilterTest, ExtractsRequiredLiterals)
+{
+  RegExpPrefilter prefilter;
+
+  // Longest first, so the rarest literal is checked first.
+  prefilter.setRegExp(QRegExp("timeout.*socket"));
+  EXPECT_EQ(QStringList() << "timeout" << "socket", prefilter.literals());
+  EXPECT_FALSE(prefilter.mayMatch("timeout"));
+
+  prefilter.setRegExp(QRegExp("colou?r"));
+  EXPECT_EQ(QStringList() << "colo" << "r", prefilter.literals());
+
+  prefilter.setRegExp(QRegExp("file\\.cpp:\\d+"));
+  EXPECT_EQ(QStringList() << "file.cpp:", prefilter.literals());
+
+  prefilter.setRegExp(QRegExp("(error|warning): failed"));
+  EXPECT_EQ(QStringList() << ": failed", prefilter.literals());
+
+  prefilter.setRegExp(QRegExp("(foo)+bar"));
+  EXPECT_EQ(QStringList() << "foo" << "bar", prefilter.literals());
+}
+
+TEST(RegExpPrefilterTest, AlternationsAndOptionalGroupsRequireNothing)
+{
+  RegExpPrefilter prefilter;
+
+  prefilter.setRegExp(QRegExp("socket|timeout"));
+  EXPECT_TRUE(prefilter.literals().isEmpty());
+
+  prefilter.setRegExp(QRegExp("(socket)?timeout"));
+  EXPECT_EQ(QStringList() << "timeout", prefilter.literals());
+
+  prefilter.setRegExp(QRegExp("(foo){0}bar"));
+  EXPECT_EQ(QStringList() << "bar", prefilter.literals());
+}
+
+TEST(RegExpPrefilterTest, RespectsCaseSensitivity)
+{
+  RegExpPrefilter prefilter;
+
+  prefilter.setRegExp(QRegExp("Timeout", Qt::CaseInsensitive));
+  EXPECT_TRUE(prefilter.mayMatch("TIMEOUT"));
+
+  prefilter.setRegExp(QRegExp("Timeout", Qt::CaseSensitive));
+  EXPECT_FALSE(prefilter.mayMatch("TIMEOUT"));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
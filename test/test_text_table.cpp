@@ -0,0 +1,86 @@
+// *****************************************************************************
+//
+// Copyright (c) 2015, Southwest Research Institute® (SwRI®)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Southwest Research Institute® (SwRI®) nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL Southwest Research Institute® BE LIABLE 
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR 
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER 
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// *****************************************************************************
+
+#include <gtest/gtest.h>
+
+#include <swri_console/text_table.h>
+
+using swri_console::TextTable;
+
+TEST(TextTableTest, SameTextSameId)
+{
+  TextTable table;
+  uint32_t id = table.intern("waiting for transform\nfrom map");
+  EXPECT_EQ(id, table.intern("waiting for transform\nfrom map"));
+  EXPECT_NE(id, table.intern("waiting for transform"));
+  EXPECT_EQ(2, table.value(id).size());
+}
+
+TEST(TextTableTest, ReleasedIdsAreReused)
+{
+  TextTable table;
+  uint32_t first = table.intern("first");
+  uint32_t second = table.intern("second");
+  uint32_t version = table.version(first);
+
+  // The body is kept until every use is released.
+  table.intern("first");
+  table.release(first);
+  EXPECT_EQ(first, table.intern("first"));
+  table.release(first);
+  table.release(first);
+
+  uint32_t third = table.intern("third");
+  EXPECT_EQ(first, third);
+  EXPECT_NE(version, table.version(third));
+  EXPECT_EQ(QStringList("third"), table.value(third));
+  EXPECT_EQ(2u, table.size());
+
+  // The released text is a new body with a new ID.
+  EXPECT_NE(first, table.intern("first"));
+  EXPECT_EQ(QStringList("second"), table.value(second));
+}
+
+TEST(TextTableTest, ClearAdvancesGeneration)
+{
+  TextTable table;
+  table.intern("first");
+  uint32_t generation = table.generation();
+  table.clear(NULL);
+  EXPECT_NE(generation, table.generation());
+  EXPECT_EQ(0u, table.size());
+  EXPECT_EQ(0u, table.intern("second"));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}